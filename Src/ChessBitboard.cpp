@@ -0,0 +1,236 @@
+#include "ChessBitboard.h"
+#include "ChessTables.h"
+
+#include <cassert>
+#include <cstddef>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CHESS_PEXT_AVAILABLE
+#include <immintrin.h>
+#endif
+
+namespace ChessProj
+{
+
+namespace
+{
+
+// fixed-shift magic multipliers for the occupancy masks below (the edge squares of the rays are left out),
+// found offline by a random search for multipliers without destructive collisions
+const Bitboard s_RookMagics[64] =
+{
+    0x3080004000802010ull, 0x0C40029005C02004ull, 0x4080100259200080ull, 0x1100042009021000ull,
+    0x2100030010080004ull, 0x1200860044001810ull, 0x0400080110008402ull, 0x2200008040240102ull,
+    0x0000800020804004ull, 0x0184804000200480ull, 0x0848801004200080ull, 0x1001001001002008ull,
+    0x8001000408001100ull, 0x0101000802040100ull, 0x4285001401000200ull, 0x008180010020C080ull,
+    0x0000228000400080ull, 0x0810004000402000ull, 0x0010008020008018ull, 0x1400090021021000ull,
+    0x820A808004000802ull, 0x0404008002008004ull, 0x0202008080020100ull, 0x094402000C025181ull,
+    0x0280400080008020ull, 0x0200200040401000ull, 0x0404482200108200ull, 0x00081022000A0040ull,
+    0x1000040080800800ull, 0x0182000200058810ull, 0x0000827400481021ull, 0x0000008200091064ull,
+    0x0040004020800089ull, 0x648E024102002082ull, 0x0000200080801000ull, 0x001200419200200Aull,
+    0x0430080080800400ull, 0x0000040080800200ull, 0x002201100400D802ull, 0x5800404082000401ull,
+    0x0000400080008020ull, 0x0140028020018044ull, 0x4004801204420020ull, 0x080210030021000Aull,
+    0x2204000408008080ull, 0x020A000804020010ull, 0x0100010002008080ull, 0x2000440040820001ull,
+    0x0000408000210100ull, 0x4000810028420200ull, 0x0A8020010043B100ull, 0x0100201000090100ull,
+    0x0001021048004500ull, 0x0002020080040080ull, 0x0048080102100400ull, 0x00410000A2084100ull,
+    0x0040110222004682ull, 0x0802002100408012ull, 0x0420040820401101ull, 0x8040200805001001ull,
+    0x0045000218001035ull, 0x840A001001080482ull, 0x0800420081300804ull, 0x0400008100402412ull
+};
+
+const Bitboard s_BishopMagics[64] =
+{
+    0x0002200800808083ull, 0x082401020E120004ull, 0x001000A208400000ull, 0x4024052600949040ull,
+    0x0002021100000101ull, 0x00220802080C0000ull, 0x000C014108210908ull, 0x024A049080901001ull,
+    0x0043C20411020210ull, 0x002020213A248100ull, 0x09224942040D0183ull, 0x01000C4220802000ull,
+    0x0041820211000400ull, 0x3000320802080800ull, 0x030084010402A000ull, 0x0210004C04040200ull,
+    0x0010014430220820ull, 0x0002042008010904ull, 0x08A0403008404040ull, 0x0260202202004000ull,
+    0x2004005211200800ull, 0x08048060C8044000ull, 0x004B003209012040ull, 0x0460802042009004ull,
+    0x2002080EC0110440ull, 0x0018022004948800ull, 0x0008404008060040ull, 0x1821080001004300ull,
+    0x0001020044008401ull, 0x4010004040241008ull, 0x0004040000A08404ull, 0x000CB10082004200ull,
+    0x6001100800112000ull, 0x06181110A4148400ull, 0x0004002480480204ull, 0x1200400808608200ull,
+    0x00A8020400001010ull, 0xC220040020010090ull, 0x00018A0080440C10ull, 0x8002020040002401ull,
+    0x180101109030C040ull, 0x8010884108801000ull, 0x0013420050048100ull, 0x010021A018008101ull,
+    0x8040080904440401ull, 0x1042240804200A00ull, 0x404802E082018400ull, 0x0010008200480089ull,
+    0x0004008404201228ull, 0x090042280402000Aull, 0x0248108888210800ull, 0x0005800E05042404ull,
+    0x08000808A1010030ull, 0x0208A02202060A10ull, 0x00C0481901461048ull, 0x00221042418104A0ull,
+    0x88084400808820C2ull, 0x0000408448421040ull, 0x0880200242009038ull, 0x0C41020080208800ull,
+    0x0000880520A24410ull, 0x00001041C4080A21ull, 0x0000295810108200ull, 0x0011201A00460020ull
+};
+
+#ifdef CHESS_PEXT_AVAILABLE
+
+// PEXT is chosen at runtime, so that the same binary runs on CPUs without BMI2.
+// Note that it is microcoded and slower than a multiplication on AMD CPUs before Zen 3
+bool IsPEXTSupported()
+{
+#ifdef _MSC_VER
+    int regs[4];
+
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return false;
+
+    __cpuidex(regs, 7, 0);
+
+    return (regs[1] & (1 << 8)) != 0; // EBX bit 8
+#else
+    __builtin_cpu_init();
+
+    return __builtin_cpu_supports("bmi2");
+#endif
+}
+
+#ifndef _MSC_VER
+__attribute__((target("bmi2")))
+#endif
+Bitboard ExtractBits(const Bitboard bb, const Bitboard mask)
+{
+    return _pext_u64(bb, mask);
+}
+
+#else
+
+bool IsPEXTSupported()
+{
+    return false;
+}
+
+Bitboard ExtractBits(const Bitboard, const Bitboard)
+{
+    return 0;
+}
+
+#endif
+
+// everything needed to look up the attacks of a slider on one square
+struct CSliderEntry
+{
+    Bitboard            m_Mask;     // the squares whose occupancy matters
+    Bitboard            m_Magic;
+    const Bitboard *    m_Attacks;  // the part of the shared attack table for the square
+    int                 m_Shift;    // 64 - number of bits in the mask
+};
+
+struct CSliderTables
+{
+    CSliderTables()
+    {
+        m_IsPEXTUsed = IsPEXTSupported();
+
+        InitSliders(m_Rook,   m_RookAttacks,   s_RookMagics,   s_OrthogonalOffsets);
+        InitSliders(m_Bishop, m_BishopAttacks, s_BishopMagics, s_DiagonalOffsets);
+    }
+
+    template <std::size_t N>
+    void InitSliders(CSliderEntry (& entries)[64], Bitboard (& attacks)[N], const Bitboard (& magics)[64], const COffset (& offsets)[4])
+    {
+        std::size_t offset = 0;
+
+        for (int index = 0; index < 64; ++index)
+        {
+            auto & entry = entries[index];
+
+            // the last square of a ray doesn't matter, nothing is behind it
+            entry.m_Mask = 0;
+
+            for (const auto & dir : offsets)
+            {
+                int rank = index / 8 + dir.m_Rank;
+                int file = index % 8 + dir.m_File;
+
+                for (; IsOnBoard(rank + dir.m_Rank, file + dir.m_File); rank += dir.m_Rank, file += dir.m_File)
+                    entry.m_Mask |= GetSquareBB(rank * 8 + file);
+            }
+
+            entry.m_Magic   = magics[index];
+            entry.m_Shift   = 64 - PopCount(entry.m_Mask);
+            entry.m_Attacks = attacks + offset;
+
+            // all the subsets of the mask (Carry-Rippler enumeration)
+            Bitboard occupied = 0;
+
+            do
+            {
+                const auto result = GetRayAttacks(index, offsets, occupied);
+
+                const auto idx = offset + GetSliderIndex(entry, occupied);
+
+                assert(idx < N);
+                assert(attacks[idx] == 0 || attacks[idx] == result); // a wrong magic
+
+                attacks[idx] = result;
+
+                occupied = (occupied - entry.m_Mask) & entry.m_Mask;
+            }
+            while (occupied);
+
+            offset += std::size_t(1) << PopCount(entry.m_Mask);
+        }
+
+        assert(offset == N);
+    }
+
+    // the squares reached by walking from the index in the directions, each walk stops at the first occupied square
+    static Bitboard GetRayAttacks(const int index, const COffset (& offsets)[4], const Bitboard occupied)
+    {
+        Bitboard result = 0;
+
+        for (const auto & dir : offsets)
+            for (int rank = index / 8 + dir.m_Rank, file = index % 8 + dir.m_File; IsOnBoard(rank, file); rank += dir.m_Rank, file += dir.m_File)
+            {
+                result |= GetSquareBB(rank * 8 + file);
+
+                if (occupied & GetSquareBB(rank * 8 + file))
+                    break;
+            }
+
+        return result;
+    }
+
+    std::size_t GetSliderIndex(const CSliderEntry & entry, const Bitboard occupied) const
+    {
+        if (m_IsPEXTUsed)
+            return static_cast<std::size_t>(ExtractBits(occupied, entry.m_Mask));
+
+        return static_cast<std::size_t>(((occupied & entry.m_Mask) * entry.m_Magic) >> entry.m_Shift);
+    }
+
+    Bitboard GetSliderAttacks(const CSliderEntry & entry, const Bitboard occupied) const
+    {
+        return entry.m_Attacks[GetSliderIndex(entry, occupied)];
+    }
+
+    CSliderEntry    m_Rook[64];
+    CSliderEntry    m_Bishop[64];
+
+    Bitboard        m_RookAttacks[102400];  // sum of 2^(mask bits) over all squares
+    Bitboard        m_BishopAttacks[5248];
+
+    bool            m_IsPEXTUsed = false;
+};
+
+const CSliderTables s_Tables;
+
+} // namespace
+
+Bitboard GetBishopAttacks(const int index, const Bitboard occupied)
+{
+    return s_Tables.GetSliderAttacks(s_Tables.m_Bishop[index], occupied);
+}
+
+Bitboard GetRookAttacks(const int index, const Bitboard occupied)
+{
+    return s_Tables.GetSliderAttacks(s_Tables.m_Rook[index], occupied);
+}
+
+Bitboard GetQueenAttacks(const int index, const Bitboard occupied)
+{
+    return GetBishopAttacks(index, occupied) | GetRookAttacks(index, occupied);
+}
+
+bool IsPEXTUsed()
+{
+    return s_Tables.m_IsPEXTUsed;
+}
+
+} // namespace ChessProj
\ No newline at end of file
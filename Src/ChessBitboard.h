@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace ChessProj
+{
+
+// 64-bit set of squares, bit index = rank * 8 + file (a1 = 0, h8 = 63, the same layout as CChessBoard::m_Pieces)
+using Bitboard = std::uint64_t;
+
+constexpr Bitboard GetSquareBB(const int index)
+{
+    return Bitboard(1) << index;
+}
+
+inline int PopCount(const Bitboard bb)
+{
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(bb));
+#else
+    return __builtin_popcountll(bb);
+#endif
+}
+
+// index of the least significant set bit, bb must be non-zero
+inline int GetLSB(const Bitboard bb)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bb);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bb);
+#endif
+}
+
+// index of the most significant set bit, bb must be non-zero
+inline int GetMSB(const Bitboard bb)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, bb);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(bb);
+#endif
+}
+
+// returns the index of the least significant set bit and clears it
+inline int PopLSB(Bitboard & bb)
+{
+    const int index = GetLSB(bb);
+
+    bb &= bb - 1;
+
+    return index;
+}
+
+// magic bitboard lookups, or PEXT (BMI2) ones when the CPU supports it
+Bitboard GetBishopAttacks(const int index, const Bitboard occupied);
+Bitboard GetRookAttacks(const int index, const Bitboard occupied);
+Bitboard GetQueenAttacks(const int index, const Bitboard occupied);
+
+bool IsPEXTUsed();
+
+} // namespace ChessProj
\ No newline at end of file
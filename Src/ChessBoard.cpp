@@ -1,4 +1,6 @@
 #include "ChessBoard.h"
+#include "ChessEval.h"
+#include "ChessZobrist.h"
 
 #include <algorithm>
 #include <cassert>
@@ -8,20 +10,22 @@ namespace ChessProj
 
 // CSquare
 
-CSquare::CSquare(const int row /*= -1*/, const int col /*= -1*/)
-    : m_Row(row)
-    , m_Col(col)
+static_assert(sizeof(CSquare) == 1, "a square must fit in a byte");
+
+CSquare::CSquare(const int rank, const int file)
 {
+    if (rank > -1 && rank < 8 && file > -1 && file < 8)
+        m_Index = static_cast<std::uint8_t>(rank * 8 + file);
 }
 
 bool CSquare::IsValid() const
 {
-    return m_Row > -1 && m_Row < 8 && m_Col > -1 && m_Col < 8;
+    return m_Index != s_InvalidIndex;
 }
 
 bool CSquare::operator==(const CSquare & other) const
 {
-    return other.m_Row == m_Row && other.m_Col == m_Col;
+    return other.m_Index == m_Index;
 }
 
 bool CSquare::operator!=(const CSquare & other) const
@@ -29,78 +33,97 @@ bool CSquare::operator!=(const CSquare & other) const
     return !(*this == other);
 }
 
-CSquare CSquare::operator+(const CSquare & other) const
+int CSquare::GetRank() const
 {
-    CSquare result;
+    assert(IsValid());
+
+    return m_Index / 8;
+}
 
-    result.m_Row = m_Row + other.m_Row;
-    result.m_Col = m_Col + other.m_Col;
+int CSquare::GetFile() const
+{
+    assert(IsValid());
 
-    return result;
+    return m_Index % 8;
 }
 
-CSquare & CSquare::operator+=(const CSquare & other)
+int CSquare::GetIndex() const
 {
-    m_Row += other.m_Row;
-    m_Col += other.m_Col;
+    assert(IsValid());
+
+    return m_Index;
+}
+
+CSquare CSquare::FromIndex(const int index)
+{
+    assert(index >= 0 && index < 64);
+
+    CSquare result;
+
+    result.m_Index = static_cast<std::uint8_t>(index);
 
-    return *this;
+    return result;
 }
 
 // CChessBoard
 
 CChessBoard::CChessBoard()
 {
-    Initialize(CChessPiece::Color::White);
+    Initialize();
 }
 
-void CChessBoard::Initialize(const CChessPiece::Color bottomColor)
+void CChessBoard::Initialize()
 {
-    m_BottomColor = bottomColor;
-
-    for (int row : {0, 7})
+    const CChessPiece::Type backRank[8] =
+    {
+        CChessPiece::Type::Rook,
+        CChessPiece::Type::Knight,
+        CChessPiece::Type::Bishop,
+        CChessPiece::Type::Queen,
+        CChessPiece::Type::King,
+        CChessPiece::Type::Bishop,
+        CChessPiece::Type::Knight,
+        CChessPiece::Type::Rook
+    };
+
+    for (int file = 0; file < 8; ++file)
     {
-        m_Pieces[row][0].SetType(CChessPiece::Type::Rook);
-        m_Pieces[row][1].SetType(CChessPiece::Type::Knight);
-        m_Pieces[row][2].SetType(CChessPiece::Type::Bishop);
-        m_Pieces[row][3].SetType(CChessPiece::Type::Queen);
-        m_Pieces[row][4].SetType(CChessPiece::Type::King);
-        m_Pieces[row][5].SetType(CChessPiece::Type::Bishop);
-        m_Pieces[row][6].SetType(CChessPiece::Type::Knight);
-        m_Pieces[row][7].SetType(CChessPiece::Type::Rook);
+        m_Pieces[file]      = CChessPiece(backRank[file],          CChessPiece::Color::White);
+        m_Pieces[8 + file]  = CChessPiece(CChessPiece::Type::Pawn, CChessPiece::Color::White);
+        m_Pieces[48 + file] = CChessPiece(CChessPiece::Type::Pawn, CChessPiece::Color::Black);
+        m_Pieces[56 + file] = CChessPiece(backRank[file],          CChessPiece::Color::Black);
     }
 
-    for (int row : {1, 6})
-        for (int col = 0; col < 8; ++col)
-            m_Pieces[row][col].SetType(CChessPiece::Type::Pawn);
+    for (int index = 16; index < 48; ++index)
+        m_Pieces[index] = CChessPiece();
 
-    for (int row = 2; row < 6; ++row)
-        for (int col = 0; col < 8; ++col)
-            m_Pieces[row][col].SetType(CChessPiece::Type::None);
+    m_WhiteKingPos = CSquare(0, 4);
+    m_BlackKingPos = CSquare(7, 4);
 
-    const auto topColor = CChessPiece::GetOppositeColor(bottomColor);
+    UpdateBitboards();
+}
 
-    for (int row = 0; row < 2; ++row)
-        for (int col = 0; col < 8; ++col)
-            m_Pieces[row][col].SetColor(topColor);
+void CChessBoard::Clear()
+{
+    for (auto & piece : m_Pieces)
+        piece = CChessPiece();
 
-    for (int row = 6; row < 8; ++row)
-        for (int col = 0; col < 8; ++col)
-            m_Pieces[row][col].SetColor(bottomColor);
+    m_WhiteKingPos = CSquare();
+    m_BlackKingPos = CSquare();
 
-    if (bottomColor == CChessPiece::Color::Black)
-    {
-        std::swap(m_Pieces[0][3], m_Pieces[0][4]);
-        std::swap(m_Pieces[7][3], m_Pieces[7][4]);
-    }
+    for (auto & bb : m_ColorBB)
+        bb = 0;
 
-    m_WhiteKingPos = (bottomColor == CChessPiece::Color::White) ? CSquare(7, 4) : CSquare(0, 3);
-    m_BlackKingPos = (bottomColor == CChessPiece::Color::White) ? CSquare(0, 4) : CSquare(7, 3);
-}
+    for (auto & bb : m_TypeBB)
+        bb = 0;
 
-CChessPiece::Color CChessBoard::GetBottomColor() const
-{
-    return m_BottomColor;
+    std::fill(&m_PieceCounts[0][0], &m_PieceCounts[0][0] + 2 * 7, std::uint8_t(0));
+
+    m_Hash = 0;
+
+    m_MiddlegameScore = 0;
+    m_EndgameScore    = 0;
+    m_GamePhase       = 0;
 }
 
 const CChessPiece & CChessBoard::GetPieceAtSquare(const CSquare & square) const
@@ -110,23 +133,57 @@ const CChessPiece & CChessBoard::GetPieceAtSquare(const CSquare & square) const
     if (!square.IsValid())
         return emptyPiece;
 
-    return m_Pieces[square.m_Row][square.m_Col];
+    return m_Pieces[square.GetIndex()];
 }
 
-std::vector<CSquare> CChessBoard::GetPieces(const CChessPiece::Color color) const
+const CChessPiece & CChessBoard::GetPieceAtIndex(const int index) const
 {
-    std::vector<CSquare> result;
-    result.reserve(16);
+    return m_Pieces[index];
+}
 
-    for (int row = 0; row < 8; ++row)
-        for (int col = 0; col < 8; ++col)
-        {
-            const auto & piece = m_Pieces[row][col];
-            if (piece.IsValid() && piece.GetColor() == color)
-                result.push_back(CSquare(row, col));
-        }
+Bitboard CChessBoard::GetOccupiedBB() const
+{
+    return m_ColorBB[0] | m_ColorBB[1];
+}
 
-    return result;
+Bitboard CChessBoard::GetColorBB(const CChessPiece::Color color) const
+{
+    return m_ColorBB[static_cast<int>(color)];
+}
+
+Bitboard CChessBoard::GetTypeBB(const CChessPiece::Type type) const
+{
+    return m_TypeBB[static_cast<int>(type)];
+}
+
+Bitboard CChessBoard::GetPiecesBB(const CChessPiece::Type type, const CChessPiece::Color color) const
+{
+    return GetTypeBB(type) & GetColorBB(color);
+}
+
+int CChessBoard::GetPieceCount(const CChessPiece::Type type, const CChessPiece::Color color) const
+{
+    return m_PieceCounts[static_cast<int>(color)][static_cast<int>(type)];
+}
+
+int CChessBoard::GetMiddlegameScore() const
+{
+    return m_MiddlegameScore;
+}
+
+int CChessBoard::GetEndgameScore() const
+{
+    return m_EndgameScore;
+}
+
+int CChessBoard::GetGamePhase() const
+{
+    return m_GamePhase;
+}
+
+std::uint64_t CChessBoard::GetHash() const
+{
+    return m_Hash;
 }
 
 const CSquare & CChessBoard::GetWhiteKingPos() const
@@ -151,27 +208,98 @@ void CChessBoard::SetPieceAtSquare(const CChessPiece & piece, const CSquare & sq
         kingPos = square;
     }
 
-    m_Pieces[square.m_Row][square.m_Col] = piece;
-}
+    const int index = square.GetIndex();
 
-std::string CChessBoard::GetSquareName(const CSquare & square) const
-{
-    assert(square.IsValid());
+    auto & pieceAtSquare = m_Pieces[index];
 
-    std::string result;
+    const auto squareBB = GetSquareBB(index);
 
-    if (m_BottomColor == CChessPiece::Color::White)
+    if (pieceAtSquare.IsValid())
     {
-        result += 'a' + square.m_Col;
-        result += '8' - square.m_Row;
+        m_ColorBB[static_cast<int>(pieceAtSquare.GetColor())] &= ~squareBB;
+        m_TypeBB[static_cast<int>(pieceAtSquare.GetType())]   &= ~squareBB;
+
+        --m_PieceCounts[static_cast<int>(pieceAtSquare.GetColor())][static_cast<int>(pieceAtSquare.GetType())];
+
+        m_Hash ^= GetZobristPieceKey(pieceAtSquare, index);
+
+        m_MiddlegameScore -= ChessProj::GetMiddlegameScore(pieceAtSquare, index);
+        m_EndgameScore    -= ChessProj::GetEndgameScore(pieceAtSquare, index);
+        m_GamePhase       -= GetGamePhaseWeight(pieceAtSquare.GetType());
     }
-    else
+
+    if (piece.IsValid())
     {
-        result += 'h' - square.m_Col;
-        result += '1' + square.m_Row;
+        m_ColorBB[static_cast<int>(piece.GetColor())] |= squareBB;
+        m_TypeBB[static_cast<int>(piece.GetType())]   |= squareBB;
+
+        ++m_PieceCounts[static_cast<int>(piece.GetColor())][static_cast<int>(piece.GetType())];
+
+        m_Hash ^= GetZobristPieceKey(piece, index);
+
+        m_MiddlegameScore += ChessProj::GetMiddlegameScore(piece, index);
+        m_EndgameScore    += ChessProj::GetEndgameScore(piece, index);
+        m_GamePhase       += GetGamePhaseWeight(piece.GetType());
     }
 
+    pieceAtSquare = piece;
+}
+
+std::string CChessBoard::GetSquareName(const CSquare & square)
+{
+    assert(square.IsValid());
+
+    std::string result;
+
+    result += 'a' + square.GetFile();
+    result += '1' + square.GetRank();
+
     return result;
 }
 
+CSquare CChessBoard::GetSquareByName(const std::string & name)
+{
+    if (name.size() != 2 || name[0] < 'a' || name[0] > 'h' || name[1] < '1' || name[1] > '8')
+        return CSquare();
+
+    return CSquare(name[1] - '1', name[0] - 'a');
+}
+
+void CChessBoard::UpdateBitboards()
+{
+    for (auto & bb : m_ColorBB)
+        bb = 0;
+
+    for (auto & bb : m_TypeBB)
+        bb = 0;
+
+    std::fill(&m_PieceCounts[0][0], &m_PieceCounts[0][0] + 2 * 7, std::uint8_t(0));
+
+    m_Hash = 0;
+
+    m_MiddlegameScore = 0;
+    m_EndgameScore    = 0;
+    m_GamePhase       = 0;
+
+    for (int index = 0; index < 64; ++index)
+    {
+        const auto & piece = m_Pieces[index];
+        if (!piece.IsValid())
+            continue;
+
+        const auto squareBB = GetSquareBB(index);
+
+        m_ColorBB[static_cast<int>(piece.GetColor())] |= squareBB;
+        m_TypeBB[static_cast<int>(piece.GetType())]   |= squareBB;
+
+        ++m_PieceCounts[static_cast<int>(piece.GetColor())][static_cast<int>(piece.GetType())];
+
+        m_Hash ^= GetZobristPieceKey(piece, index);
+
+        m_MiddlegameScore += ChessProj::GetMiddlegameScore(piece, index);
+        m_EndgameScore    += ChessProj::GetEndgameScore(piece, index);
+        m_GamePhase       += GetGamePhaseWeight(piece.GetType());
+    }
+}
+
 } // namespace ChessProj
\ No newline at end of file
@@ -1,27 +1,40 @@
 #pragma once
 
+#include "ChessBitboard.h"
 #include "ChessPiece.h"
 
+#include <cstdint>
 #include <string>
-#include <vector>
 
 namespace ChessProj
 {
 
-struct CSquare
+// a square in canonical coordinates: rank and file are counted from a1, whatever way the board is displayed.
+// Stored as its bitboard index in one byte
+class CSquare
 {
-    CSquare(const int row = -1, const int col = -1);
+public:
+    CSquare() = default; // an invalid square
+
+    // an invalid square for coordinates outside the board
+    CSquare(const int rank, const int file);
 
     bool IsValid() const;
 
     bool operator==(const CSquare & other) const;
     bool operator!=(const CSquare & other) const;
 
-    CSquare operator+(const CSquare & other) const;
-    CSquare & operator+=(const CSquare & other);
+    int GetRank() const;    // 0 = rank 1
+    int GetFile() const;    // 0 = file a
+
+    int GetIndex() const;
+
+    static CSquare FromIndex(const int index);
 
-    int m_Row = -1;
-    int m_Col = -1;
+private:
+    static const std::uint8_t s_InvalidIndex = 64;
+
+    std::uint8_t m_Index = s_InvalidIndex;
 };
 
 class CChessBoard
@@ -29,24 +42,58 @@ class CChessBoard
 public:
     CChessBoard();
 
-    void Initialize(const CChessPiece::Color bottomColor);
+    void Initialize();
 
-    CChessPiece::Color GetBottomColor() const;
+    // removes all pieces from the board
+    void Clear();
 
     const CChessPiece & GetPieceAtSquare(const CSquare & square) const;
 
-    std::vector<CSquare> GetPieces(const CChessPiece::Color color) const;
+    // unchecked access by the bitboard index (see CSquare::GetIndex)
+    const CChessPiece & GetPieceAtIndex(const int index) const;
+
+    // the bitboards double as piece lists: the squares are walked with PopLSB, without allocating
+    Bitboard GetOccupiedBB() const;
+    Bitboard GetColorBB(const CChessPiece::Color color) const;
+    Bitboard GetTypeBB(const CChessPiece::Type type) const;
+    Bitboard GetPiecesBB(const CChessPiece::Type type, const CChessPiece::Color color) const;
+
+    // kept up to date by SetPieceAtSquare
+    int GetPieceCount(const CChessPiece::Type type, const CChessPiece::Color color) const;
+
+    // sums of the evaluation terms of all the pieces (see ChessEval.h), kept up to date by SetPieceAtSquare
+    int GetMiddlegameScore() const;
+    int GetEndgameScore() const;
+    int GetGamePhase() const;
+
+    // Zobrist hash of the piece placement
+    std::uint64_t GetHash() const;
 
     const CSquare & GetWhiteKingPos() const;
     const CSquare & GetBlackKingPos() const;
 
     void SetPieceAtSquare(const CChessPiece & piece, const CSquare & square);
 
-    std::string GetSquareName(const CSquare & square) const;
+    static std::string GetSquareName(const CSquare & square);
+
+    // inverse of GetSquareName, returns an invalid square for a malformed name
+    static CSquare GetSquareByName(const std::string & name);
 
 private:
-    CChessPiece         m_Pieces[8][8];
-    CChessPiece::Color  m_BottomColor = CChessPiece::Color::White;
+    void UpdateBitboards();
+
+    CChessPiece         m_Pieces[64];   // indexed by CSquare::GetIndex
+
+    Bitboard            m_ColorBB[2];   // indexed by CChessPiece::Color
+    Bitboard            m_TypeBB[7];    // indexed by CChessPiece::Type, Type::None is unused
+
+    std::uint8_t        m_PieceCounts[2][7];    // [color][type]
+
+    std::uint64_t       m_Hash = 0;
+
+    int                 m_MiddlegameScore = 0;
+    int                 m_EndgameScore    = 0;
+    int                 m_GamePhase       = 0;
 
     CSquare             m_WhiteKingPos;
     CSquare             m_BlackKingPos;
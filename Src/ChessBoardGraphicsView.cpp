@@ -5,6 +5,7 @@
 #include <QGraphicsPixmapItem>
 #include <QMessageBox>
 #include <QMouseEvent>
+#include <QTimer>
 
 namespace ChessProj
 {
@@ -21,6 +22,8 @@ static const int            s_FontSize          = 12;
 static const std::size_t    s_MaxPiecesOnBoard  = 32;
 static const qreal          s_MovementZValue    = 150.0;
 static const qreal          s_PieceItemZValue   = 100.0;
+static const int            s_EvaluationTimeMs  = 3000;
+static const int            s_AnalysisRefreshMs = 100;
 
 static const QPixmap & GetPixmapForTypeColor(const CChessPiece::Type type, const CChessPiece::Color color)
 {
@@ -81,7 +84,10 @@ static QString GetGameStateMessage(const CChessGame::State state)
 }
 
 CBoardGraphicsView::CBoardGraphicsView()
+    : m_Search(m_TransTable)
 {
+    m_GameHashes.push_back(m_Game.GetHash());
+
     m_Font.setPointSize(s_FontSize);
     m_Font.setBold(true);
 
@@ -94,11 +100,36 @@ CBoardGraphicsView::CBoardGraphicsView()
     AddPiecesItems();
 
     UpdateBoardItems();
+
+    m_AnalysisTimer = new QTimer(this);
+    m_AnalysisTimer->setInterval(s_AnalysisRefreshMs);
+
+    connect(m_AnalysisTimer, SIGNAL(timeout()), this, SLOT(ShowAnalysis()));
+
+    // runs on the search thread, so it only stores the result for the timer to pick up
+    m_Search.SetProgressCallback([this](const CSearchResult & result)
+    {
+        std::lock_guard<std::mutex> lock(m_AnalysisMutex);
+
+        m_AnalysisResult      = result;
+        m_IsAnalysisResultNew = true;
+    });
+}
+
+CBoardGraphicsView::~CBoardGraphicsView()
+{
+    StopAnalysis();
 }
 
 void CBoardGraphicsView::StartNewGame(const bool asWhite)
 {
-    m_Game.StartNew(asWhite ? CChessPiece::Color::White : CChessPiece::Color::Black);
+    StopAnalysis();
+
+    m_IsWhiteBottom = asWhite;
+
+    m_Game.StartNew();
+
+    m_GameHashes.assign(1, m_Game.GetHash());
 
     UpdateBoardGeometry();
 
@@ -113,16 +144,16 @@ void CBoardGraphicsView::UpdateBoardItems()
 
     std::size_t pieceItemIdx = 0;
 
-    for (int r = 0; r < 8; ++r)
-        for (int c = 0; c < 8; ++c)
+    for (int rank = 0; rank < 8; ++rank)
+        for (int file = 0; file < 8; ++file)
         {
-            const auto & piece = board.GetPieceAtSquare(CSquare(r, c));
+            const auto & piece = board.GetPieceAtSquare(CSquare(rank, file));
             if (piece.GetType() == CChessPiece::Type::None)
                 continue;
 
             auto * item = m_AllPiecesItems[pieceItemIdx++];
 
-            m_BoardPiecesCache[r][c] = item;
+            m_BoardPiecesCache[rank][file] = item;
 
             item->setPixmap(GetPixmapForPiece(piece));
 
@@ -137,7 +168,94 @@ void CBoardGraphicsView::UpdateBoardItems()
 
 void CBoardGraphicsView::EvaluatePosition()
 {
-    QMessageBox::information(this, "FEN", m_Game.GetFEN().c_str(), QMessageBox::Ok);
+    StopAnalysis();
+
+    m_AnalysisGame   = m_Game;
+    m_AnalysisHashes = m_GameHashes;
+
+    m_AnalysisResult      = CSearchResult();
+    m_IsAnalysisResultNew = false;
+    m_IsAnalysisFinished  = false;
+
+    CSearchLimits limits;
+    limits.m_MaxTimeMs = s_EvaluationTimeMs;
+
+    m_Search.ResetStop();
+
+    m_AnalysisThread = std::thread([this, limits]()
+    {
+        const auto result = m_Search.Search(m_AnalysisGame, limits, m_AnalysisHashes);
+
+        std::lock_guard<std::mutex> lock(m_AnalysisMutex);
+
+        m_AnalysisResult      = result;
+        m_IsAnalysisResultNew = true;
+        m_IsAnalysisFinished  = true;
+    });
+
+    m_AnalysisTimer->start();
+}
+
+void CBoardGraphicsView::ShowAnalysis()
+{
+    CSearchResult result;
+
+    bool isFinished;
+
+    {
+        std::lock_guard<std::mutex> lock(m_AnalysisMutex);
+
+        if (!m_IsAnalysisResultNew)
+            return;
+
+        result     = m_AnalysisResult;
+        isFinished = m_IsAnalysisFinished;
+
+        m_IsAnalysisResultNew = false;
+    }
+
+    if (isFinished)
+    {
+        m_AnalysisTimer->stop();
+
+        m_AnalysisThread.join();
+    }
+
+    emit AnalysisUpdated(GetAnalysisText(result));
+}
+
+void CBoardGraphicsView::StopAnalysis()
+{
+    if (m_AnalysisThread.joinable())
+    {
+        m_Search.Stop();
+
+        m_AnalysisThread.join();
+    }
+
+    m_AnalysisTimer->stop();
+
+    // a finished analysis is of the old position as well
+    emit AnalysisUpdated(QString());
+}
+
+QString CBoardGraphicsView::GetAnalysisText(const CSearchResult & result) const
+{
+    if (!result.m_BestMove.IsValid())
+        return "No legal moves";
+
+    QString pv;
+
+    for (const auto & mv : result.m_PV)
+        pv += QString(m_AnalysisGame.GetMoveName(mv).c_str()) + " ";
+
+    const auto nodesPerSecond = (result.m_Seconds > 0.0) ? static_cast<double>(result.m_Nodes) / result.m_Seconds : 0.0;
+
+    return QString("Depth: %1   Score: %2   Nodes/s: %3   PV: %4")
+           .arg(result.m_Depth)
+           .arg(CSearch::GetScoreText(result.m_Score).c_str())
+           .arg(nodesPerSecond, 0, 'f', 0)
+           .arg(pv.trimmed());
 }
 
 void CBoardGraphicsView::resizeEvent(QResizeEvent * event)
@@ -179,8 +297,15 @@ void CBoardGraphicsView::mouseReleaseEvent(QMouseEvent * event)
 
     if (m_Game.IsMoveLegal(CChessMove(m_LastMousePressSquare, square)))
     {
+        StopAnalysis();
+
         m_Game.Move(CChessMove(m_LastMousePressSquare, square));
 
+        if (m_Game.GetHalfMoveClock() == 0)
+            m_GameHashes.clear();
+
+        m_GameHashes.push_back(m_Game.GetHash());
+
         UpdateBoardItems();
 
         if (m_Game.GetState() != CChessGame::State::Active)
@@ -198,7 +323,7 @@ void CBoardGraphicsView::mouseMoveEvent(QMouseEvent * event)
         return;
 
     if (m_LastMousePressSquare.IsValid())
-        if (auto * item = m_BoardPiecesCache[m_LastMousePressSquare.m_Row][m_LastMousePressSquare.m_Col])
+        if (auto * item = m_BoardPiecesCache[m_LastMousePressSquare.GetRank()][m_LastMousePressSquare.GetFile()])
             item->setPos(event->pos() - m_MousePosToPieceOffset);
 }
 
@@ -207,8 +332,6 @@ void CBoardGraphicsView::UpdateBoardGeometry()
     if (m_SquaresItems.empty())
         return;
 
-    const bool isWhiteBottom = m_Game.GetBoard().GetBottomColor() == CChessPiece::Color::White;
-
     assert(m_SquaresItems.size() == 64);
 
     const auto viewSize = size();
@@ -257,7 +380,7 @@ void CBoardGraphicsView::UpdateBoardGeometry()
     {
         const auto rowOffset = s_BoardMarginTop + squareSide * static_cast<qreal>(i);
 
-        const auto numberIndex = isWhiteBottom ? i : 7u - i;
+        const auto numberIndex = m_IsWhiteBottom ? i : 7u - i;
 
         m_SquaresNumbers[numberIndex]->setPos(numberXPos, rowOffset + yOffset);
     }
@@ -266,7 +389,7 @@ void CBoardGraphicsView::UpdateBoardGeometry()
 
     for (std::size_t i = 0; i < 8; ++i)
     {
-        const auto letterIndex = isWhiteBottom ? i : 7u - i;
+        const auto letterIndex = m_IsWhiteBottom ? i : 7u - i;
 
         auto * letterText = m_SquaresLetters[letterIndex];
 
@@ -286,19 +409,13 @@ void CBoardGraphicsView::UpdateBoardItemsPositions()
 {
     const auto graphicsScale = m_SquareSide / 333.0;
 
-    for (std::size_t r = 0; r < 8; ++r)
-    {
-        const auto rowOffset = s_BoardMarginTop + m_SquareSide * static_cast<qreal>(r);
-
-        for (std::size_t c = 0; c < 8; ++c)
-            if (auto * item = m_BoardPiecesCache[r][c])
+    for (int rank = 0; rank < 8; ++rank)
+        for (int file = 0; file < 8; ++file)
+            if (auto * item = m_BoardPiecesCache[rank][file])
             {
-                const auto colOffset = s_BoardMarginLeft + m_SquareSide * static_cast<qreal>(c);
-
-                item->setPos(colOffset, rowOffset);
+                item->setPos(GetPosForSquare(CSquare(rank, file)));
                 item->setScale(graphicsScale);
             }
-    }
 }
 
 void CBoardGraphicsView::AddSquaresNumbersLetters()
@@ -363,7 +480,7 @@ void CBoardGraphicsView::ReturnLastMovedPieceBack()
     if (!m_LastMousePressSquare.IsValid())
         return;
 
-    if (auto * item = m_BoardPiecesCache[m_LastMousePressSquare.m_Row][m_LastMousePressSquare.m_Col])
+    if (auto * item = m_BoardPiecesCache[m_LastMousePressSquare.GetRank()][m_LastMousePressSquare.GetFile()])
         item->setPos(GetPosForSquare(m_LastMousePressSquare));
 }
 
@@ -372,7 +489,7 @@ void CBoardGraphicsView::SetZValueForItemToMove(const float zValue)
     if (!m_LastMousePressSquare.IsValid())
         return;
 
-    if (auto * item = m_BoardPiecesCache[m_LastMousePressSquare.m_Row][m_LastMousePressSquare.m_Col])
+    if (auto * item = m_BoardPiecesCache[m_LastMousePressSquare.GetRank()][m_LastMousePressSquare.GetFile()])
         item->setZValue(zValue);
 }
 
@@ -383,22 +500,22 @@ CSquare CBoardGraphicsView::GetSquareForPoint(const QPointF & pt) const
 
     const QPointF ptBoard(pt.x() - m_BoardRect.x(), pt.y() - m_BoardRect.y());
 
-    CSquare result;
-    result.m_Row = static_cast<int>(ptBoard.y() / m_SquareSide);
-    result.m_Col = static_cast<int>(ptBoard.x() / m_SquareSide);
+    // rows and columns on the screen, counted from the top left corner
+    const int row = std::min(static_cast<int>(ptBoard.y() / m_SquareSide), 7);
+    const int col = std::min(static_cast<int>(ptBoard.x() / m_SquareSide), 7);
 
-    result.m_Row = std::min(result.m_Row, 7);
-    result.m_Col = std::min(result.m_Col, 7);
-
-    return result;
+    return m_IsWhiteBottom ? CSquare(7 - row, col) : CSquare(row, 7 - col);
 }
 
 QPointF CBoardGraphicsView::GetPosForSquare(const CSquare & square) const
 {
     assert(square.IsValid());
 
-    return QPointF(m_BoardRect.x() + static_cast<qreal>(square.m_Col) * m_SquareSide,
-                   m_BoardRect.y() + static_cast<qreal>(square.m_Row) * m_SquareSide);
+    const int row = m_IsWhiteBottom ? 7 - square.GetRank() : square.GetRank();
+    const int col = m_IsWhiteBottom ? square.GetFile() : 7 - square.GetFile();
+
+    return QPointF(m_BoardRect.x() + static_cast<qreal>(col) * m_SquareSide,
+                   m_BoardRect.y() + static_cast<qreal>(row) * m_SquareSide);
 }
 
 } // namespace ChessProj
\ No newline at end of file
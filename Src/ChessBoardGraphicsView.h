@@ -1,12 +1,19 @@
 #pragma once
 
 #include "ChessGame.h"
+#include "ChessSearch.h"
 
 #include <QGraphicsView>
 
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 class QGraphicsRectItem;
 class QGraphicsTextItem;
 class QGraphicsPixmapItem;
+class QTimer;
 
 namespace ChessProj
 {
@@ -17,20 +24,34 @@ Q_OBJECT
 
 public:
     CBoardGraphicsView();
+    ~CBoardGraphicsView() override;
 
     void StartNewGame(const bool asWhite);
 
     void UpdateBoardItems();
 
+    // starts the analysis of the current position on a worker thread, the progress comes by AnalysisUpdated
     void EvaluatePosition();
 
+signals:
+    // depth, score, principal variation and speed, an empty text when the analysis is cancelled
+    void AnalysisUpdated(const QString & text);
+
 protected:
     void resizeEvent(QResizeEvent * event) override;
     void mousePressEvent(QMouseEvent * event) override;
     void mouseReleaseEvent(QMouseEvent * event) override;
     void mouseMoveEvent(QMouseEvent * event) override;
 
+private slots:
+    void ShowAnalysis();
+
 private:
+    // cancels the running analysis, waits for its thread and clears the shown progress
+    void StopAnalysis();
+
+    QString GetAnalysisText(const CSearchResult & result) const;
+
     void UpdateBoardGeometry();
 
     void UpdateBoardItemsPositions();
@@ -55,10 +76,26 @@ private:
     std::vector<QGraphicsTextItem *>    m_SquaresNumbers;
     std::vector<QGraphicsTextItem *>    m_SquaresLetters;
     CChessGame                          m_Game;
+    std::vector<std::uint64_t>          m_GameHashes;               // since the last capture or pawn move, for the analysis
+
+    CTransTable                         m_TransTable;
+    CParallelSearch                     m_Search;
+
+    std::thread                         m_AnalysisThread;
+    CChessGame                          m_AnalysisGame;             // the analysed position, not changed while the thread runs
+    std::vector<std::uint64_t>          m_AnalysisHashes;
+    QTimer *                            m_AnalysisTimer;            // the progress is shown at its rate, however fast it comes
+
+    std::mutex                          m_AnalysisMutex;            // guards the three members below
+    CSearchResult                       m_AnalysisResult;           // the latest one
+    bool                                m_IsAnalysisResultNew = false;
+    bool                                m_IsAnalysisFinished  = false;
 
     std::vector<QGraphicsPixmapItem *>  m_AllPiecesItems;
 
-    QGraphicsPixmapItem *               m_BoardPiecesCache[8][8];
+    QGraphicsPixmapItem *               m_BoardPiecesCache[8][8];   // [rank][file]
+
+    bool                                m_IsWhiteBottom = true;     // the board is flipped only on the screen
 
     QFont                               m_Font;
 
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ChessGame.h"
+#include "ChessMappedFile.h"
+#include "ChessPGN.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ChessProj
+{
+
+// the random numbers of the Polyglot position key: 768 for the pieces, 4 for the castling rights, 8 for the en passant
+// files and 1 for white to move. The format fixes them (the Random64 array of the Polyglot sources), which is the
+// default table, so the books are interchangeable with other Polyglot programs
+class CPolyglotKeys
+{
+public:
+    static const int s_NumRandoms = 781;
+
+    CPolyglotKeys();
+
+    // replaces the table by one read from a text file: the first 781 hexadecimal numbers written with "0x", in order, so that the
+    // array copied from a C or Python source can be used as it is. Returns false (leaving the table unchanged) if
+    // the file can't be read or has fewer numbers
+    bool Load(const char * fileName);
+
+    std::uint64_t GetKey(const CChessGame & game) const;
+
+private:
+    std::uint64_t   m_Randoms[s_NumRandoms];
+};
+
+// a Polyglot book entry: 16 bytes, big-endian. The file is the entries sorted by key
+struct CBookEntry
+{
+    std::uint8_t    m_Key[8];
+    std::uint8_t    m_Move[2];      // to file, to rank, from file, from rank (3 bits each), promotion piece, castling as king takes rook
+    std::uint8_t    m_Weight[2];
+    std::uint8_t    m_Learn[4];     // unused, zero
+};
+
+static_assert(sizeof(CBookEntry) == 16, "a book entry must take 16 bytes");
+
+struct CBookMove
+{
+    CChessMove      m_Move;
+    int             m_Weight = 0;
+};
+
+// a Polyglot book, mapped into memory and searched by the key of the position. Read-only once opened,
+// so it can be shared by threads
+class CPolyglotBook
+{
+public:
+    // keysFileName is the random table for CPolyglotKeys::Load, nullptr for the default one. Returns false
+    // (leaving the book closed) if a file can't be read or the book size is not a whole number of entries
+    bool Open(const char * fileName, const char * keysFileName = nullptr);
+
+    void Close();
+
+    bool IsOpen() const;
+
+    std::size_t GetNumEntries() const;
+
+    // the legal book moves of the position, the heaviest first
+    void GetMoves(const CChessGame & game, std::vector<CBookMove> & moves) const;
+
+    // a book move with a probability in proportion to its weight, random picks it (e.g. a number from a seeded
+    // generator, for a reproducible choice). An invalid move if the position is not in the book
+    CChessMove PickMove(const CChessGame & game, const std::uint64_t random) const;
+
+private:
+    CMappedFile     m_File;
+    CPolyglotKeys   m_Keys;
+};
+
+struct CBookBuildOptions
+{
+    int     m_MaxPly   = 40;    // the moves after this many plies of a game are not entered
+    int     m_MinGames = 1;     // a move played in fewer games is left out
+};
+
+struct CBookBuildStats
+{
+    CPGNStats       m_PGNStats;
+    std::uint64_t   m_NumPositions = 0;     // distinct positions in the book
+    std::uint64_t   m_NumEntries   = 0;
+};
+
+// builds a book of the moves of the games with a result: a move scores 2 for a win of the side that made it and
+// 1 for a draw, and its weight is its score over all the games, scaled down to 16 bits if needed. The moves that
+// never scored are left out. The games are read on numThreads threads (0 = one per hardware thread) into a table
+// sharded by key, and the shards are sorted on the same threads. Returns false if a file can't be read or written
+bool BuildPolyglotBook(const char * pgnFileName, const char * bookFileName, const CPolyglotKeys & keys,
+                       const CBookBuildOptions & options, CBookBuildStats & stats, int numThreads = 0);
+
+} // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,43 @@
+# engine sources shared by the GUI and the headless tools, no Qt dependencies
+
+# the small accessors of the engine classes live in the .cpp files, link-time code generation lets them be inlined
+CONFIG      +=  ltcg
+
+# the geometry tables in ChessTables.h are constexpr inline variables
+CONFIG      +=  c++17
+
+# and take more constexpr evaluation steps than MSVC allows by default
+win32-msvc*: QMAKE_CXXFLAGS += /constexpr:steps10000000
+
+SOURCES     +=  $$PWD/ChessBitboard.cpp         \
+                $$PWD/ChessBoard.cpp            \
+                $$PWD/ChessBook.cpp             \
+                $$PWD/ChessEval.cpp             \
+                $$PWD/ChessGame.cpp             \
+                $$PWD/ChessMappedFile.cpp       \
+                $$PWD/ChessMove.cpp             \
+                $$PWD/ChessNNUE.cpp             \
+                $$PWD/ChessPGN.cpp              \
+                $$PWD/ChessPackedPosition.cpp   \
+                $$PWD/ChessPiece.cpp            \
+                $$PWD/ChessSearch.cpp           \
+                $$PWD/ChessTablebase.cpp        \
+                $$PWD/ChessTransTable.cpp       \
+                $$PWD/ChessZobrist.cpp
+
+HEADERS     +=  $$PWD/ChessBitboard.h           \
+                $$PWD/ChessBoard.h              \
+                $$PWD/ChessBook.h               \
+                $$PWD/ChessEval.h               \
+                $$PWD/ChessGame.h               \
+                $$PWD/ChessMappedFile.h         \
+                $$PWD/ChessMove.h               \
+                $$PWD/ChessNNUE.h               \
+                $$PWD/ChessPGN.h                \
+                $$PWD/ChessPackedPosition.h     \
+                $$PWD/ChessPiece.h              \
+                $$PWD/ChessSearch.h             \
+                $$PWD/ChessTablebase.h          \
+                $$PWD/ChessTables.h             \
+                $$PWD/ChessTransTable.h         \
+                $$PWD/ChessZobrist.h
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "ChessPiece.h"
+
+namespace ChessProj
+{
+
+class CChessGame;
+
+// static evaluation: material and piece-square tables for the middlegame and the endgame, blended by the game phase.
+// The board sums the terms of its pieces as they are placed and removed, so evaluating a position is O(1)
+
+// the phase with all the pieces on the board, 0 with only kings and pawns
+const int s_MaxGamePhase = 24;
+
+// scores of the piece on the square including its material, positive for white pieces
+int GetMiddlegameScore(const CChessPiece & piece, const int index);
+int GetEndgameScore(const CChessPiece & piece, const int index);
+
+// how much the piece adds to the game phase
+int GetGamePhaseWeight(const CChessPiece::Type type);
+
+// score of the position in centipawns, from the point of view of the side to move
+int Evaluate(const CChessGame & game);
+
+} // namespace ChessProj
\ No newline at end of file
@@ -1,28 +1,36 @@
 #include "ChessGame.h"
+#include "ChessPackedPosition.h"
+#include "ChessTables.h"
+#include "ChessTransTable.h"
+#include "ChessZobrist.h"
 
+#include <algorithm>
 #include <cassert>
+#include <initializer_list>
+#include <iterator>
 
 namespace ChessProj
 {
 
 CChessGame::CChessGame()
 {
-    StartNew(CChessPiece::Color::White);
+    StartNew();
 }
 
-void CChessGame::StartNew(const CChessPiece::Color color)
+void CChessGame::StartNew()
 {
     m_CurrentMoveColor = CChessPiece::Color::White;
     m_State            = State::Active;
 
-    m_Board.Initialize(color);
+    m_Board.Initialize();
 
-    m_LastMove = CChessMove();
+    m_EnPassantSquare = CSquare();
+    m_HalfMoveClock   = 0;
+    m_FullMoveNumber  = 1;
 
-    m_WhiteCanCastleKingSide  = true;
-    m_WhiteCanCastleQueenSide = true;
-    m_BlackCanCastleKingSide  = true;
-    m_BlackCanCastleQueenSide = true;
+    m_CastlingRights = s_AllCastlingRights;
+
+    m_StateHash = ComputeStateHash();
 }
 
 CChessPiece::Color CChessGame::GetCurrentMoveColor() const
@@ -40,22 +48,42 @@ CChessGame::State CChessGame::GetState() const
     return m_State;
 }
 
+std::uint64_t CChessGame::GetHash() const
+{
+    return m_Board.GetHash() ^ m_StateHash;
+}
+
+int CChessGame::GetHalfMoveClock() const
+{
+    return m_HalfMoveClock;
+}
+
+int CChessGame::GetFullMoveNumber() const
+{
+    return m_FullMoveNumber;
+}
+
+const CSquare & CChessGame::GetEnPassantSquare() const
+{
+    return m_EnPassantSquare;
+}
+
+bool CChessGame::HasCastlingRight(const CChessPiece::Color color, const bool isKingSide) const
+{
+    return (m_CastlingRights & GetCastlingRight(color, isKingSide)) != 0;
+}
+
 std::string CChessGame::GetFEN() const
 {
     std::string fen;
     fen.reserve(100);
 
-    const bool isWhiteSide = m_Board.GetBottomColor() == CChessPiece::Color::White;
-
-    const int start = isWhiteSide ? 0 :  7;
-    const int end   = isWhiteSide ? 8 : -1;
-    const int inc   = isWhiteSide ? 1 : -1;
-
-    for (int rank = start; rank != end; rank += inc)
+    // from the 8th rank down to the 1st one
+    for (int rank = 7; rank >= 0; --rank)
     {
         int emptyFiles = 0;
 
-        for (int file = start; file != end; file += inc)
+        for (int file = 0; file < 8; ++file)
         {
             const auto & piece = m_Board.GetPieceAtSquare(CSquare(rank, file));
             if (piece.IsValid())
@@ -87,646 +115,1468 @@ std::string CChessGame::GetFEN() const
 
     fen += ' ';
 
-    fen += GetEnPassantSquare();
+    fen += GetEnPassantFEN();
 
-    fen += " 0 1";
-
-    return fen;
-}
+    fen += ' ';
 
-void CChessGame::Move(const CChessMove & mv, const CChessPiece::Type promoteType /*= CChessPiece::Type::Queen*/)
-{
-    if (!IsMoveLegal(mv))
-        return;
+    fen += std::to_string(m_HalfMoveClock);
 
-    const auto piece = m_Board.GetPieceAtSquare(mv.m_From);
+    fen += ' ';
 
-    m_Board.SetPieceAtSquare(piece, mv.m_To);
+    fen += std::to_string(m_FullMoveNumber);
 
-    m_Board.SetPieceAtSquare(CChessPiece(), mv.m_From);
+    return fen;
+}
 
-    // additional piece movements (castling and en passant)
-    switch (piece.GetType())
-    {
-    case CChessPiece::Type::Pawn: HandlePawnMove(mv, promoteType); break;
-    case CChessPiece::Type::Rook: HandleRookMove(mv); break;
-    case CChessPiece::Type::King: HandleKingMove(mv); break;
-    }
+bool CChessGame::SetFEN(const char * fen)
+{
+    const CChessGame backup = *this;
 
-    m_LastMove = mv;
+    if (ParseFEN(fen))
+        return true;
 
-    m_CurrentMoveColor = CChessPiece::GetOppositeColor(piece.GetColor());
+    *this = backup;
 
-    UpdateState();
+    return false;
 }
 
-bool CChessGame::IsMoveLegal(const CChessMove & mv) const
+namespace
 {
-    if (m_State != State::Active)
-        return false;
-
-    if (!mv.IsValid())
-        return false;
 
-    const auto & pieceFrom = m_Board.GetPieceAtSquare(mv.m_From);
-    if (!pieceFrom.IsValid())
-        return false;
+// the nibbles of CPackedPosition::m_Pieces: a piece is its type - 1, plus 6 for black. The rest of the codes
+// carry the state a FEN keeps in its own fields, on the piece it belongs to
+const int s_PackedBlackOffset       = 6;
+const int s_PackedEnPassantPawn     = 12;   // the pawn that has just made a double move and can be captured en passant
+const int s_PackedWhiteCastlingRook = 13;   // a rook that can still castle
+const int s_PackedBlackCastlingRook = 14;
+const int s_PackedBlackKingToMove   = 15;   // the black king, with black to move
 
-    if (pieceFrom.GetColor() != m_CurrentMoveColor)
-        return false;
+const std::uint64_t s_MaxPackedClock = 65535;
 
-    const auto & pieceTo = m_Board.GetPieceAtSquare(mv.m_To);
-    if (pieceTo.IsValid() && pieceTo.GetColor() == pieceFrom.GetColor())
-        return false; // can't capture a valid piece of the same color. Also covers the case with (from == to)
+void WriteLittleEndian(std::uint8_t * bytes, const int numBytes, std::uint64_t value)
+{
+    for (int i = 0; i < numBytes; ++i, value >>= 8)
+        bytes[i] = static_cast<std::uint8_t>(value);
+}
 
-    switch (pieceFrom.GetType())
-    {
-    case CChessPiece::Type::Pawn :   return IsPawnMoveLegal(mv);
-    case CChessPiece::Type::Knight : return IsKnightMoveLegal(mv);
-    case CChessPiece::Type::Bishop : return IsBishopMoveLegal(mv);
-    case CChessPiece::Type::Rook :   return IsRookMoveLegal(mv);
-    case CChessPiece::Type::Queen :  return IsQueenMoveLegal(mv);
-    case CChessPiece::Type::King :   return IsKingMoveLegal(mv);
-    }
+std::uint64_t ReadLittleEndian(const std::uint8_t * bytes, const int numBytes)
+{
+    std::uint64_t value = 0;
 
-    assert(false);
+    for (int i = numBytes - 1; i >= 0; --i)
+        value = (value << 8) | bytes[i];
 
-    return false;
+    return value;
 }
 
-bool CChessGame::IsPawnMoveLegal(const CChessMove & mv) const
-{
-    const bool isMovableUp = m_Board.GetBottomColor() == m_CurrentMoveColor; // up the board, but the opposite direction in the container
+} // namespace
 
-    if ( isMovableUp && mv.m_To.m_Row >= mv.m_From.m_Row ||
-        !isMovableUp && mv.m_To.m_Row <= mv.m_From.m_Row)
-        return false; // can't move backwards or stay on the same rank
+bool CChessGame::GetPackedPosition(CPackedPosition & packed) const
+{
+    const Bitboard occupied = m_Board.GetOccupiedBB();
 
-    const int numRanks = mv.GetNumRanks();
-    if (numRanks > 2)
+    if (PopCount(occupied) > 32)
         return false;
 
-    const int numFiles = mv.GetNumFiles();
-    if (numFiles > 1)
-        return false;
+    WriteLittleEndian(packed.m_Occupied, 8, occupied);
 
-    const auto & pieceTo = m_Board.GetPieceAtSquare(mv.m_To);
+    std::fill(std::begin(packed.m_Pieces), std::end(packed.m_Pieces), std::uint8_t(0));
 
-    if (numRanks == 2) // only from starting position
-    {
-        if (numFiles != 0)
-            return false; // pawn must stay on the same file
+    const bool isWhiteToMove = m_CurrentMoveColor == CChessPiece::Color::White;
 
-        if (pieceTo.IsValid())
-            return false; // blocked by some other piece
+    // the pawn that has made the double move stands in front of the en passant square
+    const int enPassantPawnIndex = m_EnPassantSquare.IsValid() ? m_EnPassantSquare.GetIndex() + (isWhiteToMove ? -8 : 8) : -1;
 
-        if ( isMovableUp && mv.m_From.m_Row != 6 ||
-            !isMovableUp && mv.m_From.m_Row != 1)
-            return false;
+    auto IsCastlingRook = [this](const int index, const CChessPiece::Color color)
+    {
+        const int rank = (color == CChessPiece::Color::White) ? 0 : 7;
 
-        const int nextRank = (mv.m_From.m_Row + mv.m_To.m_Row) / 2;
+        return (index == rank * 8 + 7 && (m_CastlingRights & GetCastlingRight(color, true))) ||
+               (index == rank * 8     && (m_CastlingRights & GetCastlingRight(color, false)));
+    };
 
-        const auto & pieceNextRank = m_Board.GetPieceAtSquare(CSquare(nextRank, mv.m_To.m_Col));
-        if (pieceNextRank.IsValid())
-            return false; // blocked by some other piece
-    }
-    else // numRanks == 1
+    int nibble = 0;
+
+    for (Bitboard bb = occupied; bb; ++nibble)
     {
-        if (numFiles == 0 && pieceTo.IsValid())
-            return false; // blocked by some other piece
+        const int index = PopLSB(bb);
 
-        if (numFiles == 1 && !pieceTo.IsValid()) // en passant
-        {
-            // there must be a previous 2-rank pawn move
-            if (m_LastMove.GetNumRanks() != 2)
-                return false;
+        const auto & piece = m_Board.GetPieceAtIndex(index);
 
-            const auto & piecePrevMove = m_Board.GetPieceAtSquare(m_LastMove.m_To);
-            if (piecePrevMove.GetType() != CChessPiece::Type::Pawn)
-                return false;
+        const bool isWhite = piece.GetColor() == CChessPiece::Color::White;
 
-            if (m_LastMove.m_To.m_Row != mv.m_From.m_Row)
-                return false;
+        int code = static_cast<int>(piece.GetType()) - 1 + (isWhite ? 0 : s_PackedBlackOffset);
 
-            if (m_LastMove.m_To.m_Col != mv.m_To.m_Col)
-                return false;
-        }
-    }
+        if (index == enPassantPawnIndex)
+            code = s_PackedEnPassantPawn;
+        else
+        if (piece.GetType() == CChessPiece::Type::Rook && IsCastlingRook(index, piece.GetColor()))
+            code = isWhite ? s_PackedWhiteCastlingRook : s_PackedBlackCastlingRook;
+        else
+        if (piece.GetType() == CChessPiece::Type::King && !isWhite && !isWhiteToMove)
+            code = s_PackedBlackKingToMove;
 
-    CTempMove tempMove(mv, m_Board);
+        packed.m_Pieces[nibble / 2] |= static_cast<std::uint8_t>(code << (nibble % 2 * 4));
+    }
 
-    if (IsKingUnderCheck())
-        return false;
+    WriteLittleEndian(packed.m_HalfMoveClock,  2, std::min<std::uint64_t>(m_HalfMoveClock,  s_MaxPackedClock));
+    WriteLittleEndian(packed.m_FullMoveNumber, 2, std::min<std::uint64_t>(m_FullMoveNumber, s_MaxPackedClock));
 
     return true;
 }
 
-bool CChessGame::IsKnightMoveLegal(const CChessMove & mv) const
+bool CChessGame::SetPackedPosition(const CPackedPosition & packed)
 {
-    const int numRanks = mv.GetNumRanks();
-    const int numFiles = mv.GetNumFiles();
-
-    if (!(numRanks == 2 && numFiles == 1 || numRanks == 1 && numFiles == 2))
-        return false;
+    const CChessGame backup = *this;
 
-    CTempMove tempMove(mv, m_Board);
+    if (ParsePackedPosition(packed))
+        return true;
 
-    if (IsKingUnderCheck())
-        return false;
+    *this = backup;
 
-    return true;
+    return false;
 }
 
-bool CChessGame::IsBishopMoveLegal(const CChessMove & mv) const
+std::string CChessGame::GetMoveName(const CChessMove & mv) const
 {
-    if (!IsDiagonalMoveLegal(mv))
-        return false;
-
-    CTempMove tempMove(mv, m_Board);
+    std::string name = CChessBoard::GetSquareName(mv.GetFrom()) + CChessBoard::GetSquareName(mv.GetTo());
 
-    if (IsKingUnderCheck())
-        return false;
+    if (mv.GetPromotion() != CChessPiece::Type::None)
+        name += CChessPiece(mv.GetPromotion(), CChessPiece::Color::Black).GetFENChar();
 
-    return true;
+    return name;
 }
 
-bool CChessGame::IsRookMoveLegal(const CChessMove & mv) const
+CChessMove CChessGame::GetMoveByName(const std::string & name) const
 {
-    if (!IsOrthogonalMoveLegal(mv))
-        return false;
-
-    CTempMove tempMove(mv, m_Board);
+    CMoveList moves;
+    GenerateLegalMoves(moves);
 
-    if (IsKingUnderCheck())
-        return false;
+    for (const auto & mv : moves)
+        if (GetMoveName(mv) == name)
+            return mv;
 
-    return true;
+    return CChessMove();
 }
 
-bool CChessGame::IsQueenMoveLegal(const CChessMove & mv) const
+std::size_t CChessGame::GetMoveSAN(const CChessMove & mv, char * san) const
 {
-    const int numRanks = mv.GetNumRanks();
-    const int numFiles = mv.GetNumFiles();
+    static const char s_PieceLetters[] = " KQRBNP"; // indexed by CChessPiece::Type
 
-    if (numRanks == numFiles)
+    const auto from = mv.GetFrom();
+    const auto to   = mv.GetTo();
+
+    std::size_t length = 0;
+
+    if (mv.GetKind() == CChessMove::Kind::Castling)
     {
-        if (!IsDiagonalMoveLegal(mv))
-            return false;
+        const char * castling = (to.GetFile() == 6) ? "O-O" : "O-O-O";
+
+        for (; castling[length] != '\0'; ++length)
+            san[length] = castling[length];
     }
     else
-    if (numRanks == 0 && numFiles != 0 ||
-        numRanks != 0 && numFiles == 0)
     {
-        if (!IsOrthogonalMoveLegal(mv))
-            return false;
-    }
-    else
-        return false;
+        const auto type = m_Board.GetPieceAtSquare(from).GetType();
 
-    CTempMove tempMove(mv, m_Board);
+        const bool isCapture = m_Board.GetPieceAtSquare(to).IsValid() || mv.GetKind() == CChessMove::Kind::EnPassant;
 
-    if (IsKingUnderCheck())
-        return false;
+        if (type == CChessPiece::Type::Pawn)
+        {
+            if (isCapture)
+                san[length++] = static_cast<char>('a' + from.GetFile());
+        }
+        else
+        {
+            san[length++] = s_PieceLetters[static_cast<int>(type)];
 
-    return true;
-}
+            // the other pieces of the type that can legally go to the same square
+            const auto occupied = m_Board.GetOccupiedBB();
 
-bool CChessGame::IsKingMoveLegal(const CChessMove & mv) const
-{
-    const int numRanks = mv.GetNumRanks();
-    const int numFiles = mv.GetNumFiles();
+            Bitboard candidates = 0;
 
-    if (numRanks > 1 || numFiles > 2)
-        return false;
+            switch (type)
+            {
+            case CChessPiece::Type::Queen:  candidates = GetQueenAttacks(to.GetIndex(), occupied);  break;
+            case CChessPiece::Type::Rook:   candidates = GetRookAttacks(to.GetIndex(), occupied);   break;
+            case CChessPiece::Type::Bishop: candidates = GetBishopAttacks(to.GetIndex(), occupied); break;
+            case CChessPiece::Type::Knight: candidates = GetKnightAttacks(to.GetIndex());           break;
+            default:                        break; // there is only one king
+            }
 
-    if (numFiles == 2) // potential castling
-    {
-        if (numRanks != 0)
-            return false;
+            candidates &= m_Board.GetPiecesBB(type, m_CurrentMoveColor) & ~GetSquareBB(from.GetIndex());
 
-        if (IsKingUnderCheck())
-            return false; // can't castle, when under the check
+            bool isAmbiguous   = false;
+            bool isSameFile    = false;
+            bool isSameRank    = false;
 
-        const int fileInc = mv.GetFileIncrement();
+            if (candidates)
+            {
+                CCheckInfo info;
+                GetCheckInfo(info);
 
-        const bool isKingSide = (m_Board.GetBottomColor() == CChessPiece::Color::White) ? (fileInc > 0) : (fileInc < 0);
+                while (candidates)
+                {
+                    const auto other = CSquare::FromIndex(PopLSB(candidates));
 
-        const bool isCastlingAvailable = (m_CurrentMoveColor == CChessPiece::Color::White) ?
-                                         (isKingSide ? m_WhiteCanCastleKingSide : m_WhiteCanCastleQueenSide) :
-                                         (isKingSide ? m_BlackCanCastleKingSide : m_BlackCanCastleQueenSide);
+                    if (!IsPseudoLegalMoveLegal(CChessMove(other, to), info))
+                        continue;
 
-        if (!isCastlingAvailable)
-            return false;
+                    isAmbiguous = true;
+                    isSameFile |= other.GetFile() == from.GetFile();
+                    isSameRank |= other.GetRank() == from.GetRank();
+                }
+            }
 
-        const int emptySquares = isKingSide ? 2 : 3;
+            // the file if it tells the pieces apart, otherwise the rank, otherwise both
+            if (isAmbiguous && (!isSameFile || isSameRank))
+                san[length++] = static_cast<char>('a' + from.GetFile());
 
-        for (int i = 1; i <= emptySquares; ++i)
-            if (m_Board.GetPieceAtSquare(mv.m_From + CSquare(0, fileInc * i)).IsValid())
-                return false;
+            if (isAmbiguous && isSameFile)
+                san[length++] = static_cast<char>('1' + from.GetRank());
+        }
 
-        CTempMove tempMove(CChessMove(mv.m_From, mv.m_From + CSquare(0, fileInc)), m_Board);
+        if (isCapture)
+            san[length++] = 'x';
 
-        if (IsKingUnderCheck())
-            return false; // intermediate square is under attack
-    }
+        san[length++] = static_cast<char>('a' + to.GetFile());
+        san[length++] = static_cast<char>('1' + to.GetRank());
 
-    CTempMove tempMove(mv, m_Board);
+        if (mv.GetPromotion() != CChessPiece::Type::None)
+        {
+            san[length++] = '=';
+            san[length++] = s_PieceLetters[static_cast<int>(mv.GetPromotion())];
+        }
+    }
 
-    if (IsKingUnderCheck())
-        return false;
+    // the move is made on a copy, which doesn't allocate
+    CChessGame after = *this;
 
-    return true;
-}
+    CUndoInfo undo;
 
-bool CChessGame::IsDiagonalMoveLegal(const CChessMove & mv) const
-{
-    const int numRanks = mv.GetNumRanks();
-    const int numFiles = mv.GetNumFiles();
+    after.MakeMove(mv, undo);
 
-    if (numRanks != numFiles)
-        return false;
+    if (after.IsKingUnderCheck())
+        san[length++] = after.IsMoveAvailable() ? '+' : '#';
 
-    const int rankInc = mv.GetRankIncrement();
-    const int fileInc = mv.GetFileIncrement();
+    san[length] = '\0';
 
-    int rankToCheck = mv.m_From.m_Row;
-    int fileToCheck = mv.m_From.m_Col;
+    return length;
+}
 
-    for (int i = 1; i < numRanks; ++i)
-    {
-        rankToCheck += rankInc;
-        fileToCheck += fileInc;
+std::string CChessGame::GetMoveSAN(const CChessMove & mv) const
+{
+    char san[s_MaxSANLength];
 
-        if (m_Board.GetPieceAtSquare(CSquare(rankToCheck, fileToCheck)).IsValid())
-            return false;
-    }
+    const auto length = GetMoveSAN(mv, san);
 
-    return true;
+    return std::string(san, length);
 }
 
-bool CChessGame::IsOrthogonalMoveLegal(const CChessMove & mv) const
+CChessMove CChessGame::GetMoveBySAN(const char * san, std::size_t length) const
 {
-    const int numRanks = mv.GetNumRanks();
-    const int numFiles = mv.GetNumFiles();
+    while (length > 0 && (san[length - 1] == '+' || san[length - 1] == '#' || san[length - 1] == '!' || san[length - 1] == '?'))
+        --length;
 
-    if (numRanks != 0 && numFiles != 0)
-        return false;
-
-    if (numRanks != 0)
-    {
-        const int rankInc = mv.GetRankIncrement();
+    if (length < 2)
+        return CChessMove();
 
-        int rankToCheck = mv.m_From.m_Row;
+    // the legality is checked only for the moves matching the notation
+    CMoveList moves;
+    GeneratePseudoLegalMoves(moves);
 
-        for (int i = 1; i < numRanks; ++i)
-        {
-            rankToCheck += rankInc;
+    CCheckInfo info;
+    GetCheckInfo(info);
 
-            if (m_Board.GetPieceAtSquare(CSquare(rankToCheck, mv.m_From.m_Col)).IsValid())
-                return false;
-        }
-    }
-    else
+    // castling, with letters or digits
+    if (san[0] == 'O' || san[0] == '0')
     {
-        const int fileInc = mv.GetFileIncrement();
+        const bool isKingSide  = length == 3 && san[1] == '-' && san[2] == san[0];
+        const bool isQueenSide = length == 5 && san[1] == '-' && san[2] == san[0] && san[3] == '-' && san[4] == san[0];
 
-        int fileToCheck = mv.m_From.m_Col;
+        if (!isKingSide && !isQueenSide)
+            return CChessMove();
 
-        for (int i = 1; i < numFiles; ++i)
-        {
-            fileToCheck += fileInc;
+        for (const auto & mv : moves)
+            if (mv.GetKind() == CChessMove::Kind::Castling && (mv.GetTo().GetFile() == 6) == isKingSide && IsPseudoLegalMoveLegal(mv, info))
+                return mv;
 
-            if (m_Board.GetPieceAtSquare(CSquare(mv.m_From.m_Row, fileToCheck)).IsValid())
-                return false;
-        }
+        return CChessMove();
     }
 
-    return true;
-}
-
-bool CChessGame::IsKingUnderCheck() const
-{
-    const auto & kingSquare = (m_CurrentMoveColor == CChessPiece::Color::White) ?
-                              m_Board.GetWhiteKingPos() :
-                              m_Board.GetBlackKingPos();
+    auto type = CChessPiece::Type::Pawn;
 
-    const auto opponentColor = CChessPiece::GetOppositeColor(m_CurrentMoveColor);
+    std::size_t pos = 0;
 
-    // from Pawn
+    switch (san[0])
     {
-        const auto bottomColor = m_Board.GetBottomColor();
+    case 'K': type = CChessPiece::Type::King;   ++pos; break;
+    case 'Q': type = CChessPiece::Type::Queen;  ++pos; break;
+    case 'R': type = CChessPiece::Type::Rook;   ++pos; break;
+    case 'B': type = CChessPiece::Type::Bishop; ++pos; break;
+    case 'N': type = CChessPiece::Type::Knight; ++pos; break;
+    }
 
-        const int pawnRank = kingSquare.m_Row + (bottomColor == m_CurrentMoveColor ? -1 : 1);
+    auto promotion = CChessPiece::Type::None;
 
-        const auto & pawn1 = m_Board.GetPieceAtSquare(CSquare(pawnRank, kingSquare.m_Col + 1));
-        if (pawn1.GetColor() == opponentColor && pawn1.GetType() == CChessPiece::Type::Pawn)
-            return true;
+    // the promotion piece, with or without '='
+    if (type == CChessPiece::Type::Pawn)
+    {
+        switch (san[length - 1])
+        {
+        case 'Q': case 'q': promotion = CChessPiece::Type::Queen;  break;
+        case 'R': case 'r': promotion = CChessPiece::Type::Rook;   break;
+        case 'B':           promotion = CChessPiece::Type::Bishop; break;
+        case 'N': case 'n': promotion = CChessPiece::Type::Knight; break;
+        }
 
-        const auto & pawn2 = m_Board.GetPieceAtSquare(CSquare(pawnRank, kingSquare.m_Col - 1));
-        if (pawn2.GetColor() == opponentColor && pawn2.GetType() == CChessPiece::Type::Pawn)
-            return true;
-    }
+        if (promotion != CChessPiece::Type::None)
+        {
+            --length;
 
-    // from Knight
-    for (const auto & offset : s_KnightOffsets)
-    {
-        const auto & knight = m_Board.GetPieceAtSquare(kingSquare + offset);
-        if (knight.GetColor() == opponentColor && knight.GetType() == CChessPiece::Type::Knight)
-            return true;
+            if (length > 0 && san[length - 1] == '=')
+                --length;
+        }
     }
 
-    auto CheckIncrementalOffsets = [&](const std::vector<CSquare> & offsets, const CChessPiece::Type type2)
-    {
-        for (const auto & offset : offsets)
-        {
-            auto square = kingSquare + offset;
+    if (length < pos + 2)
+        return CChessMove();
 
-            while (square.IsValid())
-            {
-                const auto & piece = m_Board.GetPieceAtSquare(square);
-                if (piece.IsValid())
-                {
-                    if (piece.GetColor() == opponentColor)
-                        if (piece.GetType() == CChessPiece::Type::Queen || piece.GetType() == type2)
-                            return true;
+    // the destination is the last square, anything between it and the piece letter disambiguates the origin
+    const char toFile = san[length - 2];
+    const char toRank = san[length - 1];
 
-                    break; // blocked by a piece of the same color or non-threatening piece of the opposite color => check the next offset
-                }
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8')
+        return CChessMove();
 
-                square += offset;
-            }
-        }
+    const int toIndex = (toRank - '1') * 8 + (toFile - 'a');
 
-        return false;
-    };
+    int fromFile = -1;
+    int fromRank = -1;
 
-    // from diagonal (Queen or Bishop)
-    if (CheckIncrementalOffsets(s_DiagonalOffsets, CChessPiece::Type::Bishop))
-        return true;
+    for (; pos < length - 2; ++pos)
+    {
+        const char ch = san[pos];
+
+        if (ch >= 'a' && ch <= 'h')
+            fromFile = ch - 'a';
+        else
+        if (ch >= '1' && ch <= '8')
+            fromRank = ch - '1';
+        else
+        if (ch != 'x' && ch != '-' && ch != ':')
+            return CChessMove();
+    }
 
-    // from orthogonal (Queen or Rook)
-    if (CheckIncrementalOffsets(s_OrthogonalOffsets, CChessPiece::Type::Rook))
-        return true;
+    CChessMove result;
 
-    // from King
-    for (const auto & offset : s_KingOffsets)
+    for (const auto & mv : moves)
     {
-        const auto & king = m_Board.GetPieceAtSquare(kingSquare + offset);
-        if (king.GetColor() == opponentColor && king.GetType() == CChessPiece::Type::King)
-            return true;
+        const auto from = mv.GetFrom();
+
+        if (mv.GetTo().GetIndex() != toIndex || mv.GetPromotion() != promotion ||
+            m_Board.GetPieceAtSquare(from).GetType() != type ||
+            (fromFile >= 0 && from.GetFile() != fromFile) ||
+            (fromRank >= 0 && from.GetRank() != fromRank) ||
+            !IsPseudoLegalMoveLegal(mv, info))
+            continue;
+
+        if (result.IsValid())
+            return CChessMove(); // ambiguous
+
+        result = mv;
     }
 
-    return false;
+    return result;
 }
 
-void CChessGame::HandleKingMove(const CChessMove & mv)
+void CChessGame::Move(const CChessMove & mv, const CChessPiece::Type promoteType /*= CChessPiece::Type::Queen*/)
 {
-    const auto & king = m_Board.GetPieceAtSquare(mv.m_To);
+    const auto fullMove = GetFullMove(mv, promoteType);
 
-    assert(king.GetType() == CChessPiece::Type::King);
+    if (!IsMoveLegal(fullMove))
+        return;
 
-    bool & canCastleKingSide  = (king.GetColor() == CChessPiece::Color::White) ? m_WhiteCanCastleKingSide  : m_BlackCanCastleKingSide;
-    bool & canCastleQueenSide = (king.GetColor() == CChessPiece::Color::White) ? m_WhiteCanCastleQueenSide : m_BlackCanCastleQueenSide;
+    CUndoInfo undo;
 
-    canCastleKingSide  = false;
-    canCastleQueenSide = false;
+    MakeMove(fullMove, undo);
+
+    UpdateState();
+}
+
+void CChessGame::MakeMove(const CChessMove & mv, CUndoInfo & undo)
+{
+    const auto piece = m_Board.GetPieceAtSquare(mv.GetFrom());
+
+    assert(piece.IsValid() && piece.GetColor() == m_CurrentMoveColor);
+
+    undo.m_Captured        = m_Board.GetPieceAtSquare(mv.GetTo());
+    undo.m_EnPassantSquare = m_EnPassantSquare;
+    undo.m_HalfMoveClock   = m_HalfMoveClock;
+    undo.m_CastlingRights  = m_CastlingRights;
+    undo.m_StateHash       = m_StateHash;
+
+    if (m_EnPassantSquare.IsValid())
+        m_StateHash ^= GetZobristEnPassantKey(m_EnPassantSquare.GetFile());
+
+    m_EnPassantSquare = CSquare();
+
+    m_StateHash ^= GetZobristSideKey();
+
+    // capturing a rook on its initial square takes the castling right away
+    UpdateCastlingRights(mv.GetTo());
+
+    m_Board.SetPieceAtSquare(piece, mv.GetTo());
+
+    m_Board.SetPieceAtSquare(CChessPiece(), mv.GetFrom());
+
+    // additional piece movements (castling and en passant)
+    switch (piece.GetType())
+    {
+    case CChessPiece::Type::Pawn: HandlePawnMove(mv); break;
+    case CChessPiece::Type::Rook: HandleRookMove(mv); break;
+    case CChessPiece::Type::King: HandleKingMove(mv); break;
+    }
+
+    if (undo.m_Captured.IsValid() || piece.GetType() == CChessPiece::Type::Pawn)
+        m_HalfMoveClock = 0;
+    else
+        ++m_HalfMoveClock;
+
+    if (piece.GetColor() == CChessPiece::Color::Black)
+        ++m_FullMoveNumber;
+
+    m_CurrentMoveColor = CChessPiece::GetOppositeColor(piece.GetColor());
+
+    if (m_TransTable)
+        m_TransTable->Prefetch(GetHash());
+}
+
+void CChessGame::UnmakeMove(const CChessMove & mv, const CUndoInfo & undo)
+{
+    m_CurrentMoveColor = CChessPiece::GetOppositeColor(m_CurrentMoveColor);
+
+    auto piece = m_Board.GetPieceAtSquare(mv.GetTo());
+
+    assert(piece.IsValid() && piece.GetColor() == m_CurrentMoveColor);
+
+    const auto kind = mv.GetKind();
+
+    if (kind == CChessMove::Kind::Promotion)
+        piece.SetType(CChessPiece::Type::Pawn);
+
+    m_Board.SetPieceAtSquare(piece, mv.GetFrom());
+
+    m_Board.SetPieceAtSquare(undo.m_Captured, mv.GetTo());
+
+    if (kind == CChessMove::Kind::EnPassant)
+    {
+        const CChessPiece capturedPawn(CChessPiece::Type::Pawn, CChessPiece::GetOppositeColor(m_CurrentMoveColor));
+
+        m_Board.SetPieceAtSquare(capturedPawn, CSquare(mv.GetFrom().GetRank(), mv.GetTo().GetFile()));
+    }
+    else
+    if (kind == CChessMove::Kind::Castling)
+    {
+        CSquare rookOldSquare, rookNewSquare;
+
+        GetCastlingRookSquares(mv, rookOldSquare, rookNewSquare);
+
+        m_Board.SetPieceAtSquare(m_Board.GetPieceAtSquare(rookNewSquare), rookOldSquare);
+
+        m_Board.SetPieceAtSquare(CChessPiece(), rookNewSquare);
+    }
+
+    m_EnPassantSquare = undo.m_EnPassantSquare;
+    m_HalfMoveClock   = undo.m_HalfMoveClock;
+    m_CastlingRights  = undo.m_CastlingRights;
+    m_StateHash       = undo.m_StateHash;
+
+    if (m_CurrentMoveColor == CChessPiece::Color::Black)
+        --m_FullMoveNumber;
+}
+
+void CChessGame::SetTransTable(const CTransTable * transTable)
+{
+    m_TransTable = transTable;
+}
+
+bool CChessGame::IsMoveLegal(const CChessMove & mv) const
+{
+    if (m_State != State::Active)
+        return false;
+
+    if (!mv.IsValid())
+        return false;
+
+    const auto & pieceFrom = m_Board.GetPieceAtSquare(mv.GetFrom());
+    if (!pieceFrom.IsValid())
+        return false;
+
+    if (pieceFrom.GetColor() != m_CurrentMoveColor)
+        return false;
+
+    const auto & pieceTo = m_Board.GetPieceAtSquare(mv.GetTo());
+    if (pieceTo.IsValid() && pieceTo.GetColor() == pieceFrom.GetColor())
+        return false; // can't capture a valid piece of the same color. Also covers the case with (from == to)
+
+    // the caller may give only the squares
+    const auto fullMove = GetFullMove(mv, CChessPiece::Type::Queen);
+
+    switch (pieceFrom.GetType())
+    {
+    case CChessPiece::Type::Pawn :   return IsPawnMoveLegal(fullMove);
+    case CChessPiece::Type::Knight : return IsKnightMoveLegal(fullMove);
+    case CChessPiece::Type::Bishop : return IsBishopMoveLegal(fullMove);
+    case CChessPiece::Type::Rook :   return IsRookMoveLegal(fullMove);
+    case CChessPiece::Type::Queen :  return IsQueenMoveLegal(fullMove);
+    case CChessPiece::Type::King :   return IsKingMoveLegal(fullMove);
+    }
+
+    assert(false);
+
+    return false;
+}
+
+CChessMove CChessGame::GetFullMove(const CChessMove & mv, const CChessPiece::Type promoteType) const
+{
+    if (!mv.IsValid())
+        return mv;
+
+    const auto from = mv.GetFrom();
+    const auto to   = mv.GetTo();
+
+    switch (m_Board.GetPieceAtSquare(from).GetType())
+    {
+    case CChessPiece::Type::Pawn:
+        if (to.GetRank() == 0 || to.GetRank() == 7)
+            return CChessMove(from, to, (mv.GetPromotion() != CChessPiece::Type::None) ? mv.GetPromotion() : promoteType);
+
+        if (to == m_EnPassantSquare)
+            return CChessMove(from, to, CChessMove::Kind::EnPassant);
+
+        break;
+
+    case CChessPiece::Type::King:
+        if (mv.GetNumFiles() == 2)
+            return CChessMove(from, to, CChessMove::Kind::Castling);
+
+        break;
+    }
+
+    return CChessMove(from, to);
+}
+
+bool CChessGame::IsPawnMoveLegal(const CChessMove & mv) const
+{
+    const bool isWhite = m_CurrentMoveColor == CChessPiece::Color::White; // white pawns move to the higher ranks
+
+    if ( isWhite && mv.GetTo().GetRank() <= mv.GetFrom().GetRank() ||
+        !isWhite && mv.GetTo().GetRank() >= mv.GetFrom().GetRank())
+        return false; // can't move backwards or stay on the same rank
+
+    const int numRanks = mv.GetNumRanks();
+    if (numRanks > 2)
+        return false;
+
+    const int numFiles = mv.GetNumFiles();
+    if (numFiles > 1)
+        return false;
+
+    const auto & pieceTo = m_Board.GetPieceAtSquare(mv.GetTo());
+
+    if (numRanks == 2) // only from starting position
+    {
+        if (numFiles != 0)
+            return false; // pawn must stay on the same file
+
+        if (pieceTo.IsValid())
+            return false; // blocked by some other piece
+
+        if ( isWhite && mv.GetFrom().GetRank() != 1 ||
+            !isWhite && mv.GetFrom().GetRank() != 6)
+            return false;
+
+        const int nextRank = (mv.GetFrom().GetRank() + mv.GetTo().GetRank()) / 2;
+
+        const auto & pieceNextRank = m_Board.GetPieceAtSquare(CSquare(nextRank, mv.GetTo().GetFile()));
+        if (pieceNextRank.IsValid())
+            return false; // blocked by some other piece
+    }
+    else // numRanks == 1
+    {
+        if (numFiles == 0 && pieceTo.IsValid())
+            return false; // blocked by some other piece
+
+        // en passant: there must be a previous 2-rank pawn move over the destination square
+        if (numFiles == 1 && !pieceTo.IsValid() && mv.GetTo() != m_EnPassantSquare)
+            return false;
+    }
+
+    return IsPseudoLegalMoveLegal(mv);
+}
+
+bool CChessGame::IsKnightMoveLegal(const CChessMove & mv) const
+{
+    const int numRanks = mv.GetNumRanks();
+    const int numFiles = mv.GetNumFiles();
+
+    if (!(numRanks == 2 && numFiles == 1 || numRanks == 1 && numFiles == 2))
+        return false;
+
+    return IsPseudoLegalMoveLegal(mv);
+}
+
+bool CChessGame::IsBishopMoveLegal(const CChessMove & mv) const
+{
+    if (!IsDiagonalMoveLegal(mv))
+        return false;
+
+    return IsPseudoLegalMoveLegal(mv);
+}
+
+bool CChessGame::IsRookMoveLegal(const CChessMove & mv) const
+{
+    if (!IsOrthogonalMoveLegal(mv))
+        return false;
+
+    return IsPseudoLegalMoveLegal(mv);
+}
+
+bool CChessGame::IsQueenMoveLegal(const CChessMove & mv) const
+{
+    const int numRanks = mv.GetNumRanks();
+    const int numFiles = mv.GetNumFiles();
+
+    if (numRanks == numFiles)
+    {
+        if (!IsDiagonalMoveLegal(mv))
+            return false;
+    }
+    else
+    if (numRanks == 0 && numFiles != 0 ||
+        numRanks != 0 && numFiles == 0)
+    {
+        if (!IsOrthogonalMoveLegal(mv))
+            return false;
+    }
+    else
+        return false;
+
+    return IsPseudoLegalMoveLegal(mv);
+}
+
+bool CChessGame::IsKingMoveLegal(const CChessMove & mv) const
+{
+    const int numRanks = mv.GetNumRanks();
+    const int numFiles = mv.GetNumFiles();
+
+    if (numRanks > 1 || numFiles > 2)
+        return false;
+
+    if (numFiles == 2) // potential castling
+    {
+        if (numRanks != 0)
+            return false;
+
+        if (IsKingUnderCheck())
+            return false; // can't castle, when under the check
 
-    if (mv.GetNumFiles() == 2)
-    {
         const int fileInc = mv.GetFileIncrement();
 
-        const int rookOldCol = (fileInc > 0) ? 7 : 0;
+        const bool isKingSide = fileInc > 0;
+
+        if (!(m_CastlingRights & GetCastlingRight(m_CurrentMoveColor, isKingSide)))
+            return false;
+
+        const int emptySquares = isKingSide ? 2 : 3;
+
+        const auto from = mv.GetFrom();
+
+        for (int i = 1; i <= emptySquares; ++i)
+            if (m_Board.GetPieceAtSquare(CSquare(from.GetRank(), from.GetFile() + fileInc * i)).IsValid())
+                return false;
+
+        CTempMove tempMove(CChessMove(from, CSquare(from.GetRank(), from.GetFile() + fileInc)), m_Board);
+
+        if (IsKingUnderCheck())
+            return false; // intermediate square is under attack
+    }
+
+    CTempMove tempMove(mv, m_Board);
+
+    if (IsKingUnderCheck())
+        return false;
+
+    return true;
+}
+
+bool CChessGame::IsDiagonalMoveLegal(const CChessMove & mv) const
+{
+    // the destination is on a free diagonal from the origin
+    return (GetBishopAttacks(mv.GetFrom().GetIndex(), m_Board.GetOccupiedBB()) & GetSquareBB(mv.GetTo().GetIndex())) != 0;
+}
+
+bool CChessGame::IsOrthogonalMoveLegal(const CChessMove & mv) const
+{
+    return (GetRookAttacks(mv.GetFrom().GetIndex(), m_Board.GetOccupiedBB()) & GetSquareBB(mv.GetTo().GetIndex())) != 0;
+}
+
+bool CChessGame::IsKingUnderCheck() const
+{
+    const auto & kingSquare = (m_CurrentMoveColor == CChessPiece::Color::White) ?
+                              m_Board.GetWhiteKingPos() :
+                              m_Board.GetBlackKingPos();
+
+    return IsSquareAttacked(kingSquare, CChessPiece::GetOppositeColor(m_CurrentMoveColor));
+}
+
+bool CChessGame::IsSquareAttacked(const CSquare & square, const CChessPiece::Color attackerColor) const
+{
+    return IsSquareAttacked(square.GetIndex(), attackerColor, m_Board.GetOccupiedBB());
+}
+
+bool CChessGame::IsSquareAttacked(const int index, const CChessPiece::Color attackerColor, const Bitboard occupied) const
+{
+    // the attacking pawns stand where a pawn of the other color on the square would capture
+    const auto defenderColor = CChessPiece::GetOppositeColor(attackerColor);
+
+    if (GetPawnAttacks(index, defenderColor) & m_Board.GetPiecesBB(CChessPiece::Type::Pawn, attackerColor))
+        return true;
+
+    // from Knight
+    if (GetKnightAttacks(index) & m_Board.GetPiecesBB(CChessPiece::Type::Knight, attackerColor))
+        return true;
+
+    // from King
+    if (GetKingAttacks(index) & m_Board.GetPiecesBB(CChessPiece::Type::King, attackerColor))
+        return true;
+
+    const auto queens = m_Board.GetPiecesBB(CChessPiece::Type::Queen, attackerColor);
+
+    // from diagonal (Queen or Bishop)
+    if (GetBishopAttacks(index, occupied) & (queens | m_Board.GetPiecesBB(CChessPiece::Type::Bishop, attackerColor)))
+        return true;
+
+    // from orthogonal (Queen or Rook)
+    if (GetRookAttacks(index, occupied) & (queens | m_Board.GetPiecesBB(CChessPiece::Type::Rook, attackerColor)))
+        return true;
+
+    return false;
+}
+
+Bitboard CChessGame::GetAttackers(const int index, const CChessPiece::Color attackerColor, const Bitboard occupied) const
+{
+    const auto defenderColor = CChessPiece::GetOppositeColor(attackerColor);
+
+    const auto queens = m_Board.GetPiecesBB(CChessPiece::Type::Queen, attackerColor);
+
+    return (GetPawnAttacks(index, defenderColor)      & m_Board.GetPiecesBB(CChessPiece::Type::Pawn,   attackerColor)) |
+           (GetKnightAttacks(index)                   & m_Board.GetPiecesBB(CChessPiece::Type::Knight, attackerColor)) |
+           (GetKingAttacks(index)                     & m_Board.GetPiecesBB(CChessPiece::Type::King,   attackerColor)) |
+           (GetBishopAttacks(index, occupied)         & (queens | m_Board.GetPiecesBB(CChessPiece::Type::Bishop, attackerColor))) |
+           (GetRookAttacks(index, occupied)           & (queens | m_Board.GetPiecesBB(CChessPiece::Type::Rook,   attackerColor)));
+}
+
+void CChessGame::GetCheckInfo(CCheckInfo & info) const
+{
+    const auto opponentColor = CChessPiece::GetOppositeColor(m_CurrentMoveColor);
+
+    const auto & kingSquare = (m_CurrentMoveColor == CChessPiece::Color::White) ?
+                              m_Board.GetWhiteKingPos() :
+                              m_Board.GetBlackKingPos();
+
+    const int kingIndex = kingSquare.GetIndex();
+
+    const auto occupied = m_Board.GetOccupiedBB();
+
+    info.m_KingIndex = kingIndex;
+    info.m_Checkers  = GetAttackers(kingIndex, opponentColor, occupied);
+    info.m_Pinned    = 0;
+
+    if (!info.m_Checkers)
+        info.m_CheckMask = ~Bitboard(0);
+    else if (info.m_Checkers & (info.m_Checkers - 1))
+        info.m_CheckMask = 0; // double check, only the king can move
+    else
+        info.m_CheckMask = info.m_Checkers | GetBetweenBB(kingIndex, GetLSB(info.m_Checkers));
+
+    // the opponent's sliders that would attack the king on an empty board pin the only own piece between them
+    const auto queens = m_Board.GetPiecesBB(CChessPiece::Type::Queen, opponentColor);
+
+    auto snipers = (GetRookAttacks(kingIndex, 0)   & (queens | m_Board.GetPiecesBB(CChessPiece::Type::Rook,   opponentColor))) |
+                   (GetBishopAttacks(kingIndex, 0) & (queens | m_Board.GetPiecesBB(CChessPiece::Type::Bishop, opponentColor)));
+
+    const auto own = m_Board.GetColorBB(m_CurrentMoveColor);
+
+    while (snipers)
+    {
+        const auto blockers = GetBetweenBB(kingIndex, PopLSB(snipers)) & occupied;
+
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & own))
+            info.m_Pinned |= blockers;
+    }
+}
+
+void CChessGame::HandleKingMove(const CChessMove & mv)
+{
+    const auto & king = m_Board.GetPieceAtSquare(mv.GetTo());
+
+    assert(king.GetType() == CChessPiece::Type::King);
+
+    RemoveCastlingRights(GetCastlingRight(king.GetColor(), true) | GetCastlingRight(king.GetColor(), false));
+
+    if (mv.GetKind() == CChessMove::Kind::Castling)
+    {
+        CSquare rookOldSquare, rookNewSquare;
+
+        GetCastlingRookSquares(mv, rookOldSquare, rookNewSquare);
+
+        const auto rook = m_Board.GetPieceAtSquare(rookOldSquare);
+
+        assert(rook.GetType() == CChessPiece::Type::Rook);
+
+        assert(!m_Board.GetPieceAtSquare(rookNewSquare).IsValid());
+
+        m_Board.SetPieceAtSquare(rook, rookNewSquare);
+
+        m_Board.SetPieceAtSquare(CChessPiece(), rookOldSquare);
+    }
+}
+
+void CChessGame::HandleRookMove(const CChessMove & mv)
+{
+    assert(m_Board.GetPieceAtSquare(mv.GetTo()).GetType() == CChessPiece::Type::Rook);
+
+    UpdateCastlingRights(mv.GetFrom());
+}
+
+void CChessGame::HandlePawnMove(const CChessMove & mv)
+{
+    if (mv.GetKind() == CChessMove::Kind::Promotion)
+    {
+        auto pawnPromoted = m_Board.GetPieceAtSquare(mv.GetTo());
+
+        pawnPromoted.SetType(mv.GetPromotion());
+
+        m_Board.SetPieceAtSquare(pawnPromoted, mv.GetTo());
+
+        return;
+    }
+
+    if (mv.GetKind() == CChessMove::Kind::EnPassant)
+    {
+        m_Board.SetPieceAtSquare(CChessPiece(), CSquare(mv.GetFrom().GetRank(), mv.GetTo().GetFile()));
+
+        return;
+    }
+
+    if (mv.GetNumRanks() == 2)
+    {
+        const CSquare behindPawnSquare((mv.GetFrom().GetRank() + mv.GetTo().GetRank()) / 2, mv.GetFrom().GetFile());
+
+        const auto opponentColor = CChessPiece::GetOppositeColor(m_Board.GetPieceAtSquare(mv.GetTo()).GetColor());
+
+        if (CanCaptureEnPassant(behindPawnSquare, opponentColor))
+        {
+            m_EnPassantSquare = behindPawnSquare;
+
+            m_StateHash ^= GetZobristEnPassantKey(behindPawnSquare.GetFile());
+        }
+    }
+}
+
+bool CChessGame::CanCaptureEnPassant(const CSquare & behindPawnSquare, const CChessPiece::Color capturerColor) const
+{
+    // the capturing pawns stand where a pawn of the other color on the square would capture
+    const auto pushedPawnColor = CChessPiece::GetOppositeColor(capturerColor);
+
+    return (GetPawnAttacks(behindPawnSquare.GetIndex(), pushedPawnColor) & m_Board.GetPiecesBB(CChessPiece::Type::Pawn, capturerColor)) != 0;
+}
+
+void CChessGame::UpdateCastlingRights(const CSquare & rookSquare)
+{
+    if (rookSquare.GetRank() != 0 && rookSquare.GetRank() != 7)
+        return;
+
+    if (rookSquare.GetFile() != 0 && rookSquare.GetFile() != 7)
+        return;
+
+    const auto rookColor = (rookSquare.GetRank() == 0) ? CChessPiece::Color::White : CChessPiece::Color::Black;
+
+    RemoveCastlingRights(GetCastlingRight(rookColor, rookSquare.GetFile() == 7));
+}
+
+void CChessGame::RemoveCastlingRights(const std::uint8_t rights)
+{
+    const std::uint8_t newRights = m_CastlingRights & ~rights;
+
+    m_StateHash ^= GetZobristCastlingKey(m_CastlingRights) ^ GetZobristCastlingKey(newRights);
+
+    m_CastlingRights = newRights;
+}
+
+void CChessGame::GetCastlingRookSquares(const CChessMove & kingMove, CSquare & rookOldSquare, CSquare & rookNewSquare)
+{
+    const int rookOldFile = (kingMove.GetFileIncrement() > 0) ? 7 : 0;
+
+    const int rookNewFile = (kingMove.GetFrom().GetFile() + kingMove.GetTo().GetFile()) / 2;
+
+    rookOldSquare = CSquare(kingMove.GetTo().GetRank(), rookOldFile);
+
+    rookNewSquare = CSquare(kingMove.GetTo().GetRank(), rookNewFile);
+}
+
+std::uint8_t CChessGame::GetCastlingRight(const CChessPiece::Color color, const bool isKingSide)
+{
+    if (color == CChessPiece::Color::White)
+        return isKingSide ? s_WhiteKingSide : s_WhiteQueenSide;
 
-        const int rookNewCol = (mv.m_From.m_Col + mv.m_To.m_Col) / 2;
+    return isKingSide ? s_BlackKingSide : s_BlackQueenSide;
+}
 
-        const auto rookOldSquare = CSquare(mv.m_To.m_Row, rookOldCol);
+bool CChessGame::ParseFEN(const char * fen)
+{
+    m_Board.Clear();
 
-        const auto rookNewSquare = CSquare(mv.m_To.m_Row, rookNewCol);
+    m_State = State::Active;
 
-        const auto rook = m_Board.GetPieceAtSquare(rookOldSquare);
+    const char * ch = fen;
 
-        assert(rook.GetType() == CChessPiece::Type::Rook);
+    auto SkipSpaces = [&ch]()
+    {
+        const char * start = ch;
 
-        assert(!m_Board.GetPieceAtSquare(rookNewSquare).IsValid());
+        while (*ch == ' ')
+            ++ch;
 
-        m_Board.SetPieceAtSquare(rook, rookNewSquare);
+        return ch != start;
+    };
 
-        m_Board.SetPieceAtSquare(CChessPiece(), rookOldSquare);
+    auto ParseNumber = [&ch](int & value)
+    {
+        if (*ch < '0' || *ch > '9')
+            return false;
+
+        for (value = 0; *ch >= '0' && *ch <= '9'; ++ch)
+            value = value * 10 + (*ch - '0');
+
+        return true;
+    };
+
+    SkipSpaces();
+
+    // piece placement from the 8th rank down to the 1st one
+    int rank = 7;
+    int file = 0;
+
+    for (; *ch != '\0' && *ch != ' '; ++ch)
+    {
+        if (*ch == '/')
+        {
+            if (file != 8 || rank == 0)
+                return false;
+
+            --rank;
+            file = 0;
+
+            continue;
+        }
+
+        if (*ch >= '1' && *ch <= '8')
+        {
+            file += *ch - '0';
+
+            if (file > 8)
+                return false;
+
+            continue;
+        }
+
+        const auto piece = CChessPiece::FromFENChar(*ch);
+
+        if (!piece.IsValid() || file > 7)
+            return false;
+
+        if (piece.GetType() == CChessPiece::Type::Pawn && (rank == 0 || rank == 7))
+            return false;
+
+        if (piece.GetType() == CChessPiece::Type::King && m_Board.GetPiecesBB(CChessPiece::Type::King, piece.GetColor()))
+            return false; // only one king of each color
+
+        m_Board.SetPieceAtSquare(piece, CSquare(rank, file++));
     }
-}
 
-void CChessGame::HandleRookMove(const CChessMove & mv)
-{
-    if (mv.m_From.m_Col != 0 && mv.m_From.m_Col != 7)
-        return;
+    if (rank != 0 || file != 8)
+        return false;
 
-    const auto & rook = m_Board.GetPieceAtSquare(mv.m_To);
+    if (!m_Board.GetWhiteKingPos().IsValid() || !m_Board.GetBlackKingPos().IsValid())
+        return false;
 
-    assert(rook.GetType() == CChessPiece::Type::Rook);
+    // side to move
+    if (!SkipSpaces())
+        return false;
 
-    bool & canCastleKingSide  = (rook.GetColor() == CChessPiece::Color::White) ? m_WhiteCanCastleKingSide  : m_BlackCanCastleKingSide;
-    bool & canCastleQueenSide = (rook.GetColor() == CChessPiece::Color::White) ? m_WhiteCanCastleQueenSide : m_BlackCanCastleQueenSide;
+    switch (*ch++)
+    {
+    case 'w': m_CurrentMoveColor = CChessPiece::Color::White; break;
+    case 'b': m_CurrentMoveColor = CChessPiece::Color::Black; break;
+    default:
+        return false;
+    }
 
-    if (!canCastleKingSide && !canCastleQueenSide)
-        return;
+    // castling rights
+    if (!SkipSpaces())
+        return false;
 
-    const bool isKingSide = (m_Board.GetBottomColor() == CChessPiece::Color::White) ? (mv.m_From.m_Col == 7) : (mv.m_From.m_Col == 0);
+    m_CastlingRights = 0;
 
-    if (isKingSide)
-        canCastleKingSide  = false;
+    if (*ch == '-')
+        ++ch;
     else
-        canCastleQueenSide = false;
-}
+        for (; *ch != '\0' && *ch != ' '; ++ch)
+            switch (*ch)
+            {
+            case 'K': m_CastlingRights |= s_WhiteKingSide;  break;
+            case 'Q': m_CastlingRights |= s_WhiteQueenSide; break;
+            case 'k': m_CastlingRights |= s_BlackKingSide;  break;
+            case 'q': m_CastlingRights |= s_BlackQueenSide; break;
+            default:
+                return false;
+            }
 
-void CChessGame::HandlePawnMove(const CChessMove & mv, const CChessPiece::Type promoteType)
-{
-    if (mv.m_To.m_Row == 0 || mv.m_To.m_Row == 7)
+    ValidateCastlingRights();
+
+    // en passant square
+    if (!SkipSpaces())
+        return false;
+
+    m_EnPassantSquare = CSquare();
+
+    if (*ch == '-')
+        ++ch;
+    else
     {
-        auto pawnPromoted = m_Board.GetPieceAtSquare(mv.m_To);
+        const bool isWhiteToMove = m_CurrentMoveColor == CChessPiece::Color::White;
+
+        if (ch[0] < 'a' || ch[0] > 'h' || ch[1] != (isWhiteToMove ? '6' : '3'))
+            return false;
 
-        pawnPromoted.SetType(promoteType);
+        const int enPassantFile = ch[0] - 'a';
+        const int enPassantRank = ch[1] - '1';
 
-        m_Board.SetPieceAtSquare(pawnPromoted, mv.m_To);
+        ch += 2;
 
-        return;
+        const int pawnRankInc = isWhiteToMove ? -1 : 1; // direction of the opponent's double pawn move
+
+        const auto & pawn = m_Board.GetPieceAtSquare(CSquare(enPassantRank + pawnRankInc, enPassantFile));
+
+        const CSquare behindPawnSquare(enPassantRank, enPassantFile);
+
+        // an inconsistent or useless square is ignored rather than rejected, some generators always write it
+        if (pawn.GetType() == CChessPiece::Type::Pawn && pawn.GetColor() != m_CurrentMoveColor &&
+            !m_Board.GetPieceAtSquare(behindPawnSquare).IsValid() &&
+            !m_Board.GetPieceAtSquare(CSquare(enPassantRank - pawnRankInc, enPassantFile)).IsValid() &&
+            CanCaptureEnPassant(behindPawnSquare, m_CurrentMoveColor))
+            m_EnPassantSquare = behindPawnSquare;
     }
 
-    if (m_LastMove.GetNumRanks() == 2            &&
-        m_LastMove.m_To.m_Row == mv.m_From.m_Row &&
-        m_LastMove.m_To.m_Col == mv.m_To.m_Col)
+    // move counters are optional
+    m_HalfMoveClock  = 0;
+    m_FullMoveNumber = 1;
+
+    if (SkipSpaces() && *ch != '\0')
     {
-        const auto & pawn = m_Board.GetPieceAtSquare(m_LastMove.m_To);
-        if (pawn.GetType() == CChessPiece::Type::Pawn)
-            m_Board.SetPieceAtSquare(CChessPiece(), m_LastMove.m_To);
+        if (!ParseNumber(m_HalfMoveClock))
+            return false;
+
+        if (SkipSpaces() && *ch != '\0')
+        {
+            if (!ParseNumber(m_FullMoveNumber))
+                return false;
+
+            if (m_FullMoveNumber < 1)
+                m_FullMoveNumber = 1;
+        }
     }
+
+    const auto & opponentKing = (m_CurrentMoveColor == CChessPiece::Color::White) ? m_Board.GetBlackKingPos() : m_Board.GetWhiteKingPos();
+
+    if (IsSquareAttacked(opponentKing, m_CurrentMoveColor))
+        return false; // the side that has just moved can't be in check
+
+    m_StateHash = ComputeStateHash();
+
+    UpdateState();
+
+    return true;
 }
 
-bool CChessGame::IsMoveAvailable() const
+bool CChessGame::ParsePackedPosition(const CPackedPosition & packed)
 {
-    const auto piecesSquares = m_Board.GetPieces(m_CurrentMoveColor);
+    m_Board.Clear();
+
+    m_State            = State::Active;
+    m_CurrentMoveColor = CChessPiece::Color::White;
+    m_CastlingRights   = 0;
+    m_EnPassantSquare  = CSquare();
+
+    const Bitboard occupied = ReadLittleEndian(packed.m_Occupied, 8);
 
-    for (const auto & square : piecesSquares)
+    if (PopCount(occupied) > 32)
+        return false;
+
+    int enPassantPawnIndex = -1;
+
+    int nibble = 0;
+
+    for (Bitboard bb = occupied; bb; ++nibble)
     {
-        const auto piece = m_Board.GetPieceAtSquare(square);
+        const int index = PopLSB(bb);
 
-        switch (piece.GetType())
+        const int code = (packed.m_Pieces[nibble / 2] >> (nibble % 2 * 4)) & 15;
+
+        CChessPiece piece;
+
+        switch (code)
         {
-        case CChessPiece::Type::Pawn:
+        case s_PackedEnPassantPawn:
+            if (enPassantPawnIndex >= 0)
+                return false;
+
+            enPassantPawnIndex = index; // its color is known once the side to move is
+
+            continue;
+
+        case s_PackedWhiteCastlingRook:
+        case s_PackedBlackCastlingRook:
         {
-            const int rankInc = (m_Board.GetBottomColor() == m_CurrentMoveColor) ? -1 : 1;
+            const auto color = (code == s_PackedWhiteCastlingRook) ? CChessPiece::Color::White : CChessPiece::Color::Black;
 
-            const std::vector<CSquare> offsets =
-            {
-                CSquare(rankInc,  0),
-                CSquare(rankInc, -1),
-                CSquare(rankInc,  1),
-                CSquare(2 * rankInc, 0)
-            };
+            const int rank = (color == CChessPiece::Color::White) ? 0 : 7;
 
-            for (const auto & offset : offsets)
-            {
-                const auto squareTo = square + offset;
+            if (index != rank * 8 && index != rank * 8 + 7)
+                return false;
 
-                const auto & pieceTo = m_Board.GetPieceAtSquare(squareTo);
-                if (pieceTo.IsValid() && pieceTo.GetColor() == m_CurrentMoveColor)
-                    continue;
+            m_CastlingRights |= GetCastlingRight(color, index == rank * 8 + 7);
 
-                if (IsPawnMoveLegal(CChessMove(square, squareTo)))
-                    return true;
-            }
+            piece = CChessPiece(CChessPiece::Type::Rook, color);
 
             break;
         }
-        case CChessPiece::Type::Bishop:
-        {
-            if (IsMoveAvailableIncremental(square, s_DiagonalOffsets))
-                return true;
 
-            break;
-        }
-        case CChessPiece::Type::Knight:
-        {
-            if (IsMoveAvailableStatic(square, s_KnightOffsets))
-                return true;
+        case s_PackedBlackKingToMove:
+            m_CurrentMoveColor = CChessPiece::Color::Black;
 
-            break;
-        }
-        case CChessPiece::Type::King:
-        {
-            if (IsMoveAvailableStatic(square, s_KingOffsets))
-                return true;
+            piece = CChessPiece(CChessPiece::Type::King, CChessPiece::Color::Black);
 
             break;
-        }
-        case CChessPiece::Type::Rook:
-        {
-            if (IsMoveAvailableIncremental(square, s_OrthogonalOffsets))
-                return true;
 
-            break;
+        default:
+            piece = CChessPiece(static_cast<CChessPiece::Type>(code % s_PackedBlackOffset + 1),
+                                (code < s_PackedBlackOffset) ? CChessPiece::Color::White : CChessPiece::Color::Black);
         }
-        case CChessPiece::Type::Queen:
+
+        const int rank = index / 8;
+
+        if (piece.GetType() == CChessPiece::Type::Pawn && (rank == 0 || rank == 7))
+            return false;
+
+        if (piece.GetType() == CChessPiece::Type::King && m_Board.GetPiecesBB(CChessPiece::Type::King, piece.GetColor()))
+            return false; // only one king of each color
+
+        m_Board.SetPieceAtSquare(piece, CSquare::FromIndex(index));
+    }
+
+    // the nibbles past the pieces are zero, so that a position has a single record
+    for (; nibble < 32; ++nibble)
+        if ((packed.m_Pieces[nibble / 2] >> (nibble % 2 * 4)) & 15)
+            return false;
+
+    if (!m_Board.GetWhiteKingPos().IsValid() || !m_Board.GetBlackKingPos().IsValid())
+        return false;
+
+    // the rooks have to be in place for their rights, the kings too
+    const auto castlingRights = m_CastlingRights;
+
+    ValidateCastlingRights();
+
+    if (m_CastlingRights != castlingRights)
+        return false;
+
+    if (enPassantPawnIndex >= 0)
+    {
+        const bool isWhiteToMove = m_CurrentMoveColor == CChessPiece::Color::White;
+
+        // the square the pawn has skipped and the one it has come from
+        const int behindPawnIndex = enPassantPawnIndex + (isWhiteToMove ? 8 : -8);
+        const int pawnStartIndex  = enPassantPawnIndex + (isWhiteToMove ? 16 : -16);
+
+        if (enPassantPawnIndex / 8 != (isWhiteToMove ? 4 : 3))
+            return false;
+
+        if (occupied & (GetSquareBB(behindPawnIndex) | GetSquareBB(pawnStartIndex)))
+            return false;
+
+        m_Board.SetPieceAtSquare(CChessPiece(CChessPiece::Type::Pawn, CChessPiece::GetOppositeColor(m_CurrentMoveColor)),
+                                 CSquare::FromIndex(enPassantPawnIndex));
+
+        m_EnPassantSquare = CSquare::FromIndex(behindPawnIndex);
+
+        if (!CanCaptureEnPassant(m_EnPassantSquare, m_CurrentMoveColor))
+            return false;
+    }
+
+    m_HalfMoveClock  = static_cast<int>(ReadLittleEndian(packed.m_HalfMoveClock,  2));
+    m_FullMoveNumber = static_cast<int>(ReadLittleEndian(packed.m_FullMoveNumber, 2));
+
+    if (m_FullMoveNumber < 1)
+        return false;
+
+    const auto & opponentKing = (m_CurrentMoveColor == CChessPiece::Color::White) ? m_Board.GetBlackKingPos() : m_Board.GetWhiteKingPos();
+
+    if (IsSquareAttacked(opponentKing, m_CurrentMoveColor))
+        return false; // the side that has just moved can't be in check
+
+    m_StateHash = ComputeStateHash();
+
+    UpdateState();
+
+    return true;
+}
+
+void CChessGame::ValidateCastlingRights()
+{
+    for (const auto color : {CChessPiece::Color::White, CChessPiece::Color::Black})
+    {
+        const int rank = (color == CChessPiece::Color::White) ? 0 : 7;
+
+        const auto & king = m_Board.GetPieceAtSquare(CSquare(rank, 4));
+
+        const bool isKingInPlace = king.GetType() == CChessPiece::Type::King && king.GetColor() == color;
+
+        auto IsRookAt = [&](const int file)
         {
-            if (IsMoveAvailableIncremental(square, s_DiagonalOffsets))
-                return true;
+            const auto & rook = m_Board.GetPieceAtSquare(CSquare(rank, file));
 
-            if (IsMoveAvailableIncremental(square, s_OrthogonalOffsets))
-                return true;
+            return rook.GetType() == CChessPiece::Type::Rook && rook.GetColor() == color;
+        };
 
-            break;
-        }
-        }
+        if (!isKingInPlace || !IsRookAt(7))
+            m_CastlingRights &= ~GetCastlingRight(color, true);
+
+        if (!isKingInPlace || !IsRookAt(0))
+            m_CastlingRights &= ~GetCastlingRight(color, false);
     }
+}
 
-    return false;
+void CChessGame::GenerateLegalMoves(CMoveList & moves) const
+{
+    GeneratePseudoLegalMoves(moves);
+
+    RemoveIllegalMoves(moves);
+}
+
+void CChessGame::GenerateLegalCaptures(CMoveList & moves) const
+{
+    GeneratePseudoLegalMoves(moves, true);
+
+    RemoveIllegalMoves(moves);
 }
 
-bool CChessGame::IsMoveAvailableIncremental(const CSquare & square, const std::vector<CSquare> & offsets) const
+void CChessGame::RemoveIllegalMoves(CMoveList & moves) const
 {
-    const auto pieceType = m_Board.GetPieceAtSquare(square).GetType();
+    CCheckInfo info;
+    GetCheckInfo(info);
+
+    auto * pMoves = moves.GetMoves();
+
+    std::size_t numLegal = 0;
+
+    for (std::size_t i = 0; i < moves.m_Size; ++i)
+        if (IsPseudoLegalMoveLegal(pMoves[i], info))
+            pMoves[numLegal++] = pMoves[i];
+
+    moves.m_Size = numLegal;
+}
+
+void CChessGame::GeneratePseudoLegalMoves(CMoveList & moves, const bool isCapturesOnly /*= false*/) const
+{
+    moves.Clear();
+
+    const auto opponentColor = CChessPiece::GetOppositeColor(m_CurrentMoveColor);
+
+    const auto own      = m_Board.GetColorBB(m_CurrentMoveColor);
+    const auto opponent = m_Board.GetColorBB(opponentColor);
+    const auto occupied = own | opponent;
 
-    assert(pieceType == CChessPiece::Type::Bishop || pieceType == CChessPiece::Type::Rook || pieceType == CChessPiece::Type::Queen);
+    const auto targets  = isCapturesOnly ? opponent : ~own;
 
-    for (const auto & offset : offsets)
+    auto AddMoves = [&moves](const int from, Bitboard targets)
     {
-        auto squareTo = square + offset;
+        const auto squareFrom = CSquare::FromIndex(from);
 
-        while (squareTo.IsValid())
-        {
-            const auto & piece = m_Board.GetPieceAtSquare(squareTo);
-            if (piece.IsValid() && piece.GetColor() == m_CurrentMoveColor)
-                break; // blocked by a piece of the same color
+        while (targets)
+            moves.Add(CChessMove(squareFrom, CSquare::FromIndex(PopLSB(targets))));
+    };
 
-            switch (pieceType)
-            {
-            case CChessPiece::Type::Bishop:
-            {
-                if (IsBishopMoveLegal(CChessMove(square, squareTo)))
-                    return true;
+    // Pawn
+    {
+        const bool isWhite = m_CurrentMoveColor == CChessPiece::Color::White;
 
-                break;
-            }
-            case CChessPiece::Type::Rook:
+        const int forward   = isWhite ? 8 : -8;
+        const int startRank = isWhite ? 1 :  6;
+        const int lastRank  = isWhite ? 7 :  0;
+
+        const auto enPassantBB = m_EnPassantSquare.IsValid() ? GetSquareBB(m_EnPassantSquare.GetIndex()) : Bitboard(0);
+
+        auto AddPawnMove = [&moves, lastRank](const CSquare & from, const CSquare & to)
+        {
+            if (to.GetRank() != lastRank)
             {
-                if (IsRookMoveLegal(CChessMove(square, squareTo)))
-                    return true;
+                moves.Add(CChessMove(from, to));
 
-                break;
+                return;
             }
-            case CChessPiece::Type::Queen:
+
+            for (const auto type : {CChessPiece::Type::Queen, CChessPiece::Type::Rook, CChessPiece::Type::Bishop, CChessPiece::Type::Knight})
+                moves.Add(CChessMove(from, to, type));
+        };
+
+        for (auto pawns = m_Board.GetPiecesBB(CChessPiece::Type::Pawn, m_CurrentMoveColor); pawns; )
+        {
+            const int from = PopLSB(pawns);
+
+            const auto squareFrom = CSquare::FromIndex(from);
+
+            const int oneRank = from + forward;
+
+            // only promotions among the pushes count as captures
+            const bool isPushAllowed = !isCapturesOnly || CSquare::FromIndex(oneRank).GetRank() == lastRank;
+
+            if (isPushAllowed && !(occupied & GetSquareBB(oneRank)))
             {
-                if (IsQueenMoveLegal(CChessMove(square, squareTo)))
-                    return true;
+                AddPawnMove(squareFrom, CSquare::FromIndex(oneRank));
 
-                break;
-            }
+                const int twoRanks = oneRank + forward;
+
+                if (!isCapturesOnly && squareFrom.GetRank() == startRank && !(occupied & GetSquareBB(twoRanks)))
+                    moves.Add(CChessMove(squareFrom, CSquare::FromIndex(twoRanks)));
             }
 
-            if (piece.IsValid())
-                break; // blocked by a piece of the opposite color that cannot be taken => stop iterating this offset
+            const auto attacks = GetPawnAttacks(from, m_CurrentMoveColor);
+
+            for (auto captures = attacks & opponent; captures; )
+                AddPawnMove(squareFrom, CSquare::FromIndex(PopLSB(captures)));
 
-            squareTo += offset;
+            if (attacks & enPassantBB)
+                moves.Add(CChessMove(squareFrom, m_EnPassantSquare, CChessMove::Kind::EnPassant));
         }
     }
 
-    return false;
+    // Knight
+    for (auto knights = m_Board.GetPiecesBB(CChessPiece::Type::Knight, m_CurrentMoveColor); knights; )
+    {
+        const int from = PopLSB(knights);
+
+        AddMoves(from, GetKnightAttacks(from) & targets);
+    }
+
+    // Bishop
+    for (auto bishops = m_Board.GetPiecesBB(CChessPiece::Type::Bishop, m_CurrentMoveColor); bishops; )
+    {
+        const int from = PopLSB(bishops);
+
+        AddMoves(from, GetBishopAttacks(from, occupied) & targets);
+    }
+
+    // Rook
+    for (auto rooks = m_Board.GetPiecesBB(CChessPiece::Type::Rook, m_CurrentMoveColor); rooks; )
+    {
+        const int from = PopLSB(rooks);
+
+        AddMoves(from, GetRookAttacks(from, occupied) & targets);
+    }
+
+    // Queen
+    for (auto queens = m_Board.GetPiecesBB(CChessPiece::Type::Queen, m_CurrentMoveColor); queens; )
+    {
+        const int from = PopLSB(queens);
+
+        AddMoves(from, GetQueenAttacks(from, occupied) & targets);
+    }
+
+    // King
+    {
+        const auto & kingSquare = (m_CurrentMoveColor == CChessPiece::Color::White) ?
+                                  m_Board.GetWhiteKingPos() :
+                                  m_Board.GetBlackKingPos();
+
+        AddMoves(kingSquare.GetIndex(), GetKingAttacks(kingSquare.GetIndex()) & targets);
+
+        if (isCapturesOnly)
+            return;
+
+        // castling candidates, the remaining conditions are checked by IsKingMoveLegal
+        const int kingIndex = kingSquare.GetIndex();
+
+        if (m_CastlingRights & GetCastlingRight(m_CurrentMoveColor, true))
+            moves.Add(CChessMove(kingSquare, CSquare::FromIndex(kingIndex + 2), CChessMove::Kind::Castling));
+
+        if (m_CastlingRights & GetCastlingRight(m_CurrentMoveColor, false))
+            moves.Add(CChessMove(kingSquare, CSquare::FromIndex(kingIndex - 2), CChessMove::Kind::Castling));
+    }
 }
 
-bool CChessGame::IsMoveAvailableStatic(const CSquare & square, const std::vector<CSquare> & offsets) const
+bool CChessGame::IsPseudoLegalMoveLegal(const CChessMove & mv) const
 {
-    const auto pieceType = m_Board.GetPieceAtSquare(square).GetType();
+    CCheckInfo info;
+    GetCheckInfo(info);
 
-    assert(pieceType == CChessPiece::Type::Knight || pieceType == CChessPiece::Type::King);
+    return IsPseudoLegalMoveLegal(mv, info);
+}
 
-    for (const auto & offset : offsets)
-    {
-        const auto squareTo = square + offset;
-        if (!squareTo.IsValid())
-            continue;
+bool CChessGame::IsPseudoLegalMoveLegal(const CChessMove & mv, const CCheckInfo & info) const
+{
+    const int from = mv.GetFrom().GetIndex();
+    const int to   = mv.GetTo().GetIndex();
 
-        const auto & piece = m_Board.GetPieceAtSquare(squareTo);
-        if (piece.IsValid() && piece.GetColor() == m_CurrentMoveColor)
-            continue; // can't capture a piece of the same color
+    if (from == info.m_KingIndex)
+    {
+        if (mv.GetKind() == CChessMove::Kind::Castling)
+            return IsKingMoveLegal(mv);
 
-        switch (pieceType)
-        {
-        case CChessPiece::Type::Knight:
-        {
-            if (IsKnightMoveLegal(CChessMove(square, squareTo)))
-                return true;
+        // without the king on the board, so that it can't hide behind itself from a slider
+        return !IsSquareAttacked(to, CChessPiece::GetOppositeColor(m_CurrentMoveColor), m_Board.GetOccupiedBB() ^ GetSquareBB(from));
+    }
 
-            break;
-        }
-        case CChessPiece::Type::King:
-        {
-            if (IsKingMoveLegal(CChessMove(square, squareTo)))
-                return true;
+    if (mv.GetKind() == CChessMove::Kind::EnPassant)
+    {
+        // rare, and two pieces leave the line between the king and a slider, so it is checked by making the move
+        CTempMove tempMove(mv, m_Board, CSquare(mv.GetFrom().GetRank(), mv.GetTo().GetFile()));
 
-            break;
-        }
-        }
+        return !IsKingUnderCheck();
     }
 
+    if (!(info.m_CheckMask & GetSquareBB(to)))
+        return false;
+
+    // a pinned piece can only move along the pin line
+    return !(info.m_Pinned & GetSquareBB(from)) || (GetLineBB(info.m_KingIndex, from) & GetSquareBB(to));
+}
+
+bool CChessGame::IsMoveAvailable() const
+{
+    CCheckInfo info;
+    GetCheckInfo(info);
+
+    CMoveList moves;
+    GeneratePseudoLegalMoves(moves);
+
+    for (const auto & mv : moves)
+        if (IsPseudoLegalMoveLegal(mv, info))
+            return true;
+
     return false;
 }
 
@@ -741,42 +1591,47 @@ void CChessGame::UpdateState()
         m_State = State::Draw;
 }
 
+std::uint64_t CChessGame::ComputeStateHash() const
+{
+    std::uint64_t hash = GetZobristCastlingKey(m_CastlingRights);
+
+    if (m_CurrentMoveColor == CChessPiece::Color::Black)
+        hash ^= GetZobristSideKey();
+
+    if (m_EnPassantSquare.IsValid())
+        hash ^= GetZobristEnPassantKey(m_EnPassantSquare.GetFile());
+
+    return hash;
+}
+
 std::string CChessGame::GetCastleFEN() const
 {
-    if (!m_WhiteCanCastleKingSide && !m_WhiteCanCastleQueenSide && !m_BlackCanCastleKingSide && !m_BlackCanCastleQueenSide)
+    if (m_CastlingRights == 0)
         return "-";
 
     std::string fen;
 
-    if (m_WhiteCanCastleKingSide)
+    if (m_CastlingRights & s_WhiteKingSide)
         fen += 'K';
 
-    if (m_WhiteCanCastleQueenSide)
+    if (m_CastlingRights & s_WhiteQueenSide)
         fen += 'Q';
 
-    if (m_BlackCanCastleKingSide)
+    if (m_CastlingRights & s_BlackKingSide)
         fen += 'k';
 
-    if (m_BlackCanCastleQueenSide)
+    if (m_CastlingRights & s_BlackQueenSide)
         fen += 'q';
 
     return fen;
 }
 
-std::string CChessGame::GetEnPassantSquare() const
+std::string CChessGame::GetEnPassantFEN() const
 {
-    if (!m_LastMove.IsValid()         ||
-        m_LastMove.GetNumFiles() != 0 ||
-        m_LastMove.GetNumRanks() != 2)
-        return "-";
-
-    const auto & pawn = m_Board.GetPieceAtSquare(m_LastMove.m_To);
-    if (pawn.GetType() != CChessPiece::Type::Pawn)
+    if (!m_EnPassantSquare.IsValid())
         return "-";
 
-    const auto behindPawnSquare = CSquare(m_LastMove.m_From.m_Row + m_LastMove.GetRankIncrement(), m_LastMove.m_From.m_Col);
-
-    return m_Board.GetSquareName(behindPawnSquare);
+    return CChessBoard::GetSquareName(m_EnPassantSquare);
 }
 
 } // namespace ChessProj
\ No newline at end of file
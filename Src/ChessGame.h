@@ -2,11 +2,26 @@
 
 #include "ChessMove.h"
 
+#include <cstdint>
 #include <string>
 
 namespace ChessProj
 {
 
+class CTransTable;
+
+struct CPackedPosition;
+
+// the part of the position MakeMove overwrites and UnmakeMove can't restore from the move itself
+struct CUndoInfo
+{
+    CChessPiece     m_Captured;         // empty for a move to an empty square, including en passant
+    CSquare         m_EnPassantSquare;
+    std::uint64_t   m_StateHash      = 0;
+    int             m_HalfMoveClock  = 0;
+    std::uint8_t    m_CastlingRights = 0;
+};
+
 class CChessGame
 {
 public:
@@ -18,9 +33,12 @@ public:
         BlackWon
     };
 
+    // the longest SAN with the terminating zero, e.g. "Qa1xb2+" or "exd8=Q#"
+    static const std::size_t s_MaxSANLength = 8;
+
     CChessGame();
 
-    void StartNew(const CChessPiece::Color color);
+    void StartNew();
 
     CChessPiece::Color GetCurrentMoveColor() const;
 
@@ -28,13 +46,80 @@ public:
 
     State GetState() const;
 
+    // Zobrist hash of the position: pieces, side to move, castling rights and the en passant column
+    std::uint64_t GetHash() const;
+
+    int GetHalfMoveClock() const;
+    int GetFullMoveNumber() const;
+
+    // the square a pawn of the side to move can capture en passant on, invalid if there is none
+    const CSquare & GetEnPassantSquare() const;
+
+    bool HasCastlingRight(const CChessPiece::Color color, const bool isKingSide) const;
+
     std::string GetFEN() const;
 
+    // sets up the position without allocating, returns false (leaving the game unchanged) for a malformed FEN
+    bool SetFEN(const char * fen);
+
+    // the position in 32 bytes (see ChessPackedPosition.h), the user data of the record is left as it is. Returns false
+    // for more than 32 pieces, which no game can reach. The clocks are saturated at 65535, so that any position
+    // reached in a game round-trips exactly
+    bool GetPackedPosition(CPackedPosition & packed) const;
+
+    // sets up the position, returns false (leaving the game unchanged) for an inconsistent record
+    bool SetPackedPosition(const CPackedPosition & packed);
+
+    // long algebraic notation, e.g. "e2e4" or "e7e8q"
+    std::string GetMoveName(const CChessMove & mv) const;
+
+    // the legal move with the name in long algebraic notation, an invalid move if there is none
+    CChessMove GetMoveByName(const std::string & name) const;
+
+    // writes the legal move in standard algebraic notation, with the origin disambiguated as little as possible
+    // and the check or mate suffix, into a buffer of at least s_MaxSANLength chars. Returns the length
+    std::size_t GetMoveSAN(const CChessMove & mv, char * san) const;
+
+    std::string GetMoveSAN(const CChessMove & mv) const;
+
+    // the legal move in standard algebraic notation, e.g. "Nbd7", "exd6", "e8=Q+" or "O-O". Check, mate and annotation
+    // suffixes are ignored. An invalid move if there is no such move or the notation is ambiguous
+    CChessMove GetMoveBySAN(const char * san, std::size_t length) const;
+
     void Move(const CChessMove & mv, const CChessPiece::Type promoteType = CChessPiece::Type::Queen);
 
     bool IsMoveLegal(const CChessMove & mv) const;
 
+    // fills the list with all legal moves of the side to move, every promotion piece is a separate move
+    void GenerateLegalMoves(CMoveList & moves) const;
+
+    // legal captures (en passant included) and promotions, for the quiescence search
+    void GenerateLegalCaptures(CMoveList & moves) const;
+
+    // whether the side to move is in check
+    bool IsKingUnderCheck() const;
+
+    // reversible move for walking the game tree in place. The move must be legal (e.g. come from GenerateLegalMoves)
+    // and carry its kind (see CChessMove::Kind). The game state is not updated, callers detect mate and stalemate themselves
+    void MakeMove(const CChessMove & mv, CUndoInfo & undo);
+    void UnmakeMove(const CChessMove & mv, const CUndoInfo & undo);
+
+    // MakeMove prefetches the table bucket of the new position, nullptr turns it off
+    void SetTransTable(const CTransTable * transTable);
+
 private:
+    // the pieces checking the side to move and its absolutely pinned pieces, computed once per position
+    struct CCheckInfo
+    {
+        Bitboard    m_Checkers  = 0;
+        Bitboard    m_Pinned    = 0;
+        Bitboard    m_CheckMask = ~Bitboard(0); // where a non-king move has to go: the checker or a square between it and the king
+        int         m_KingIndex = 0;
+    };
+
+    // the move with the kind and the promotion piece set from the position, for a move given by its squares only
+    CChessMove GetFullMove(const CChessMove & mv, const CChessPiece::Type promoteType) const;
+
     bool IsPawnMoveLegal(const CChessMove & mv) const;
     bool IsKnightMoveLegal(const CChessMove & mv) const;
     bool IsBishopMoveLegal(const CChessMove & mv) const;
@@ -45,30 +130,63 @@ private:
     bool IsDiagonalMoveLegal(const CChessMove & mv) const;
     bool IsOrthogonalMoveLegal(const CChessMove & mv) const;
 
-    bool IsKingUnderCheck() const;
+    bool IsSquareAttacked(const CSquare & square, const CChessPiece::Color attackerColor) const;
+    bool IsSquareAttacked(const int index, const CChessPiece::Color attackerColor, const Bitboard occupied) const;
+
+    Bitboard GetAttackers(const int index, const CChessPiece::Color attackerColor, const Bitboard occupied) const;
+
+    void GetCheckInfo(CCheckInfo & info) const;
 
     void HandleKingMove(const CChessMove & mv);
     void HandleRookMove(const CChessMove & mv);
-    void HandlePawnMove(const CChessMove & mv, const CChessPiece::Type promoteType);
+    void HandlePawnMove(const CChessMove & mv);
+
+    void UpdateCastlingRights(const CSquare & rookSquare);
+
+    static void GetCastlingRookSquares(const CChessMove & kingMove, CSquare & rookOldSquare, CSquare & rookNewSquare);
+
+    static std::uint8_t GetCastlingRight(const CChessPiece::Color color, const bool isKingSide);
+
+    void RemoveCastlingRights(const std::uint8_t rights);
+
+    bool CanCaptureEnPassant(const CSquare & behindPawnSquare, const CChessPiece::Color capturerColor) const;
+
+    // the part of the hash that is not kept by the board
+    std::uint64_t ComputeStateHash() const;
+
+    void GeneratePseudoLegalMoves(CMoveList & moves, const bool isCapturesOnly = false) const;
+    bool IsPseudoLegalMoveLegal(const CChessMove & mv) const;
+    bool IsPseudoLegalMoveLegal(const CChessMove & mv, const CCheckInfo & info) const;
+
+    void RemoveIllegalMoves(CMoveList & moves) const;
 
     bool IsMoveAvailable() const;
-    bool IsMoveAvailableIncremental(const CSquare & square, const std::vector<CSquare> & offsets) const;
-    bool IsMoveAvailableStatic(const CSquare & square, const std::vector<CSquare> & offsets) const;
 
     void UpdateState();
 
+    bool ParseFEN(const char * fen);
+    bool ParsePackedPosition(const CPackedPosition & packed);
+
+    void ValidateCastlingRights();
+
     std::string GetCastleFEN() const;
-    std::string GetEnPassantSquare() const;
+    std::string GetEnPassantFEN() const;
+
+    static const std::uint8_t s_WhiteKingSide      = 1;
+    static const std::uint8_t s_WhiteQueenSide     = 2;
+    static const std::uint8_t s_BlackKingSide      = 4;
+    static const std::uint8_t s_BlackQueenSide     = 8;
+    static const std::uint8_t s_AllCastlingRights  = 15;
 
     mutable CChessBoard     m_Board;
-    CChessMove              m_LastMove;
+    CSquare                 m_EnPassantSquare;        // the square skipped by the double pawn move that has just been made, if a pawn can capture there
+    int                     m_HalfMoveClock           = 0;
+    int                     m_FullMoveNumber          = 1;
     CChessPiece::Color      m_CurrentMoveColor        = CChessPiece::Color::White;
     State                   m_State                   = State::Active;
-
-    bool                    m_WhiteCanCastleKingSide  = true;
-    bool                    m_WhiteCanCastleQueenSide = true;
-    bool                    m_BlackCanCastleKingSide  = true;
-    bool                    m_BlackCanCastleQueenSide = true;
+    std::uint8_t            m_CastlingRights          = s_AllCastlingRights;
+    std::uint64_t           m_StateHash               = 0;      // side to move, castling and en passant keys
+    const CTransTable *     m_TransTable              = nullptr;
 };
 
 } // namespace ChessProj
\ No newline at end of file
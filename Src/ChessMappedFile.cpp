@@ -0,0 +1,131 @@
+#include "ChessMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ChessProj
+{
+
+CMappedFile::~CMappedFile()
+{
+    Close();
+}
+
+bool CMappedFile::Open(const char * fileName)
+{
+    Close();
+
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+
+        return false;
+    }
+
+    if (size.QuadPart > 0)
+    {
+        const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        // the view keeps the mapping and the file alive
+        const void * view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if (mapping)
+            CloseHandle(mapping);
+
+        if (!view)
+        {
+            CloseHandle(file);
+
+            return false;
+        }
+
+        m_Data = static_cast<const char *>(view);
+        m_Size = static_cast<std::size_t>(size.QuadPart);
+    }
+
+    CloseHandle(file);
+#else
+    const int file = open(fileName, O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat info;
+
+    if (fstat(file, &info) != 0)
+    {
+        close(file);
+
+        return false;
+    }
+
+    if (info.st_size > 0)
+    {
+        // the mapping keeps the file alive
+        void * view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+        if (view == MAP_FAILED)
+        {
+            close(file);
+
+            return false;
+        }
+
+        m_Data = static_cast<const char *>(view);
+        m_Size = static_cast<std::size_t>(info.st_size);
+    }
+
+    close(file);
+#endif
+
+    m_IsOpen = true;
+
+    return true;
+}
+
+void CMappedFile::Close()
+{
+    if (m_Data)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_Data);
+#else
+        munmap(const_cast<char *>(m_Data), m_Size);
+#endif
+    }
+
+    m_Data   = nullptr;
+    m_Size   = 0;
+    m_IsOpen = false;
+}
+
+bool CMappedFile::IsOpen() const
+{
+    return m_IsOpen;
+}
+
+const char * CMappedFile::GetData() const
+{
+    return m_Data;
+}
+
+std::size_t CMappedFile::GetSize() const
+{
+    return m_Size;
+}
+
+} // namespace ChessProj
\ No newline at end of file
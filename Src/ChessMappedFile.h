@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ChessProj
+{
+
+// a whole file mapped read-only into memory. The pages are loaded by the OS on first access and shared
+// by all the processes mapping the same file, so a multi-gigabyte file costs no reading up front
+class CMappedFile
+{
+public:
+    CMappedFile() = default;
+    ~CMappedFile();
+
+    CMappedFile(const CMappedFile &) = delete;
+    CMappedFile & operator=(const CMappedFile &) = delete;
+
+    // returns false if the file can't be opened or mapped. An empty file is mapped as an empty range
+    bool Open(const char * fileName);
+
+    void Close();
+
+    bool IsOpen() const;
+
+    const char * GetData() const;
+    std::size_t GetSize() const;
+
+private:
+    const char *    m_Data   = nullptr;
+    std::size_t     m_Size   = 0;
+    bool            m_IsOpen = false;
+};
+
+} // namespace ChessProj
\ No newline at end of file
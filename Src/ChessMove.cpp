@@ -1,107 +1,212 @@
 #include "ChessMove.h"
 
 #include <algorithm>
+#include <cassert>
+#include <new>
 
 namespace ChessProj
 {
 
-// pieces offsets
+// CChessMove
+
+static_assert(sizeof(CChessMove) == 2, "a move must fit in 16 bits");
 
-const std::vector<CSquare> s_KingOffsets =
+namespace
 {
-    CSquare(-1, -1),
-    CSquare(-1,  0),
-    CSquare(-1,  1),
-    CSquare( 1, -1),
-    CSquare( 1,  0),
-    CSquare( 1,  1),
-    CSquare( 0, -1),
-    CSquare( 0,  1)
-};
 
-const std::vector<CSquare> s_KnightOffsets =
+const int s_ToShift        = 6;
+const int s_PromotionShift = 12;
+const int s_KindShift      = 14;
+
+// the promotion bits count down from the knight: Knight = 0, Bishop = 1, Rook = 2, Queen = 3
+const int s_PromotionBase  = static_cast<int>(CChessPiece::Type::Knight);
+
+} // namespace
+
+CChessMove::CChessMove(const CSquare & from, const CSquare & to, const CChessPiece::Type promotion /*= CChessPiece::Type::None*/)
+    : CChessMove(from, to, (promotion != CChessPiece::Type::None) ? Kind::Promotion : Kind::Normal)
+{
+    if (m_Data != 0 && promotion != CChessPiece::Type::None)
+    {
+        assert(promotion >= CChessPiece::Type::Queen && promotion <= CChessPiece::Type::Knight);
+
+        m_Data |= static_cast<std::uint16_t>((s_PromotionBase - static_cast<int>(promotion)) << s_PromotionShift);
+    }
+}
+
+CChessMove::CChessMove(const CSquare & from, const CSquare & to, const Kind kind)
 {
-    CSquare(-2, -1),
-    CSquare(-2,  1),
-    CSquare(-1, -2),
-    CSquare(-1,  2),
-    CSquare( 1, -2),
-    CSquare( 1,  2),
-    CSquare( 2, -1),
-    CSquare( 2,  1)
-};
+    if (!from.IsValid() || !to.IsValid())
+        return;
 
-const std::vector<CSquare> s_DiagonalOffsets =
+    m_Data = static_cast<std::uint16_t>(from.GetIndex() | to.GetIndex() << s_ToShift | static_cast<int>(kind) << s_KindShift);
+}
+
+bool CChessMove::IsValid() const
 {
-    CSquare(-1, -1),
-    CSquare(-1,  1),
-    CSquare( 1,  1),
-    CSquare( 1, -1)
-};
+    return m_Data != 0; // a1-a1 is never a move
+}
 
-const std::vector<CSquare> s_OrthogonalOffsets =
+bool CChessMove::operator==(const CChessMove & other) const
 {
-    CSquare(-1,  0),
-    CSquare( 1,  0),
-    CSquare( 0,  1),
-    CSquare( 0, -1)
-};
+    return other.m_Data == m_Data;
+}
 
-// CChessMove
+bool CChessMove::operator!=(const CChessMove & other) const
+{
+    return !(*this == other);
+}
 
-CChessMove::CChessMove(const CSquare from /*= CSquare()*/, const CSquare to /*= CSquare()*/)
-    : m_From(from)
-    , m_To(to)
+CSquare CChessMove::GetFrom() const
 {
+    return CSquare::FromIndex(m_Data & 63);
 }
 
-bool CChessMove::IsValid() const
+CSquare CChessMove::GetTo() const
 {
-    return m_From.IsValid() && m_To.IsValid();
+    return CSquare::FromIndex((m_Data >> s_ToShift) & 63);
+}
+
+CChessMove::Kind CChessMove::GetKind() const
+{
+    return static_cast<Kind>(m_Data >> s_KindShift);
+}
+
+CChessPiece::Type CChessMove::GetPromotion() const
+{
+    if (GetKind() != Kind::Promotion)
+        return CChessPiece::Type::None;
+
+    return static_cast<CChessPiece::Type>(s_PromotionBase - ((m_Data >> s_PromotionShift) & 3));
 }
 
 int CChessMove::GetNumRanks() const
 {
-    return std::abs(m_To.m_Row - m_From.m_Row);
+    return std::abs(GetTo().GetRank() - GetFrom().GetRank());
 }
 
 int CChessMove::GetNumFiles() const
 {
-    return std::abs(m_To.m_Col - m_From.m_Col);
+    return std::abs(GetTo().GetFile() - GetFrom().GetFile());
 }
 
 int CChessMove::GetRankIncrement() const
 {
-    if (m_To.m_Row == m_From.m_Row)
+    const int fromRank = GetFrom().GetRank();
+    const int toRank   = GetTo().GetRank();
+
+    if (toRank == fromRank)
         return 0;
 
-    return (m_To.m_Row > m_From.m_Row) ? 1 : -1;
+    return (toRank > fromRank) ? 1 : -1;
 }
 
 int CChessMove::GetFileIncrement() const
 {
-    if (m_To.m_Col == m_From.m_Col)
+    const int fromFile = GetFrom().GetFile();
+    const int toFile   = GetTo().GetFile();
+
+    if (toFile == fromFile)
         return 0;
 
-    return (m_To.m_Col > m_From.m_Col) ? 1 : -1;
+    return (toFile > fromFile) ? 1 : -1;
+}
+
+std::uint16_t CChessMove::GetData() const
+{
+    return m_Data;
+}
+
+CChessMove CChessMove::FromData(const std::uint16_t data)
+{
+    CChessMove result;
+
+    result.m_Data = data;
+
+    return result;
+}
+
+// CMoveList
+
+CMoveList::CMoveList(const CMoveList & other)
+{
+    *this = other;
+}
+
+CMoveList & CMoveList::operator=(const CMoveList & other)
+{
+    m_Size = 0;
+
+    for (const auto & mv : other)
+        Add(mv);
+
+    return *this;
+}
+
+void CMoveList::Clear()
+{
+    m_Size = 0;
+}
+
+void CMoveList::Add(const CChessMove & mv)
+{
+    assert(m_Size < s_MaxMoves);
+
+    new (m_Storage + m_Size++ * sizeof(CChessMove)) CChessMove(mv);
+}
+
+std::size_t CMoveList::GetSize() const
+{
+    return m_Size;
+}
+
+bool CMoveList::IsEmpty() const
+{
+    return m_Size == 0;
+}
+
+const CChessMove & CMoveList::operator[](const std::size_t idx) const
+{
+    assert(idx < m_Size);
+
+    return begin()[idx];
+}
+
+const CChessMove * CMoveList::begin() const
+{
+    return reinterpret_cast<const CChessMove *>(m_Storage);
+}
+
+const CChessMove * CMoveList::end() const
+{
+    return begin() + m_Size;
+}
+
+CChessMove * CMoveList::GetMoves()
+{
+    return reinterpret_cast<CChessMove *>(m_Storage);
 }
 
 // CTempMove
 
-CTempMove::CTempMove(const CChessMove & mv, CChessBoard & board)
+CTempMove::CTempMove(const CChessMove & mv, CChessBoard & board, const CSquare & capturedSquare /*= CSquare()*/)
     : m_Mv(mv)
-    , m_PieceFrom(board.GetPieceAtSquare(mv.m_From))
-    , m_PieceTo(board.GetPieceAtSquare(mv.m_To))
+    , m_PieceFrom(board.GetPieceAtSquare(mv.GetFrom()))
+    , m_PieceTo(board.GetPieceAtSquare(mv.GetTo()))
+    , m_CapturedSquare(capturedSquare)
+    , m_PieceCaptured(board.GetPieceAtSquare(capturedSquare))
     , m_Board(board)
 {
-    m_Board.SetPieceAtSquare(m_PieceFrom,   m_Mv.m_To);
-    m_Board.SetPieceAtSquare(CChessPiece(), m_Mv.m_From);
+    m_Board.SetPieceAtSquare(CChessPiece(), m_CapturedSquare);
+    m_Board.SetPieceAtSquare(m_PieceFrom,   m_Mv.GetTo());
+    m_Board.SetPieceAtSquare(CChessPiece(), m_Mv.GetFrom());
 }
 
 CTempMove::~CTempMove()
 {
-    m_Board.SetPieceAtSquare(m_PieceTo,   m_Mv.m_To);
-    m_Board.SetPieceAtSquare(m_PieceFrom, m_Mv.m_From);
+    m_Board.SetPieceAtSquare(m_PieceTo,       m_Mv.GetTo());
+    m_Board.SetPieceAtSquare(m_PieceFrom,     m_Mv.GetFrom());
+    m_Board.SetPieceAtSquare(m_PieceCaptured, m_CapturedSquare);
 }
 
 } // namespace ChessProj
\ No newline at end of file
@@ -2,42 +2,106 @@
 
 #include "ChessBoard.h"
 
+#include <cstddef>
+#include <cstdint>
+
 namespace ChessProj
 {
 
-struct CChessMove
+// packed into 16 bits: the origin and destination indices (6 bits each), the promotion piece and the kind (2 bits each)
+class CChessMove
 {
-    CChessMove(const CSquare from = CSquare(), const CSquare to = CSquare());
+public:
+    enum class Kind : std::uint8_t
+    {
+        Normal,
+        Promotion,
+        EnPassant,
+        Castling
+    };
+
+    CChessMove() = default; // an invalid move
+
+    // a move with a promotion piece is a Kind::Promotion one
+    CChessMove(const CSquare & from, const CSquare & to, const CChessPiece::Type promotion = CChessPiece::Type::None);
+
+    CChessMove(const CSquare & from, const CSquare & to, const Kind kind);
 
     bool IsValid() const;
 
+    bool operator==(const CChessMove & other) const;
+    bool operator!=(const CChessMove & other) const;
+
+    CSquare GetFrom() const;
+    CSquare GetTo() const;
+
+    Kind GetKind() const;
+
+    // Type::None for all the moves but promotions
+    CChessPiece::Type GetPromotion() const;
+
     int GetNumRanks() const;
     int GetNumFiles() const;
 
     int GetRankIncrement() const;
     int GetFileIncrement() const;
 
-    CSquare     m_From;
-    CSquare     m_To;
+    // the packed bits, 0 for an invalid move
+    std::uint16_t GetData() const;
+
+    static CChessMove FromData(const std::uint16_t data);
+
+private:
+    std::uint16_t       m_Data = 0;
+};
+
+// fixed-capacity list of moves, meant to live on the stack
+class CMoveList
+{
+public:
+    static const std::size_t s_MaxMoves = 256; // more than the 218 legal moves possible in any position
+
+    CMoveList() = default;
+    CMoveList(const CMoveList & other);
+    CMoveList & operator=(const CMoveList & other);
+
+    void Clear();
+
+    void Add(const CChessMove & mv);
+
+    std::size_t GetSize() const;
+    bool IsEmpty() const;
+
+    const CChessMove & operator[](const std::size_t idx) const;
+
+    const CChessMove * begin() const;
+    const CChessMove * end() const;
+
+private:
+    friend class CChessGame;
+
+    CChessMove * GetMoves();
+
+    // raw storage, so that creating a list doesn't construct all the moves
+    alignas(CChessMove) unsigned char   m_Storage[s_MaxMoves * sizeof(CChessMove)];
+    std::size_t                         m_Size = 0;
 };
 
 class CTempMove
 {
 public:
-    CTempMove(const CChessMove & mv, CChessBoard & board);
+    // capturedSquare is the square of a pawn taken en passant, which differs from the destination square
+    CTempMove(const CChessMove & mv, CChessBoard & board, const CSquare & capturedSquare = CSquare());
     ~CTempMove();
 
 private:
     const CChessMove    m_Mv;
     const CChessPiece   m_PieceFrom;
     const CChessPiece   m_PieceTo;
+    const CSquare       m_CapturedSquare;
+    const CChessPiece   m_PieceCaptured;
 
     CChessBoard &       m_Board;
 };
 
-extern const std::vector<CSquare> s_KingOffsets;
-extern const std::vector<CSquare> s_KnightOffsets;
-extern const std::vector<CSquare> s_DiagonalOffsets;
-extern const std::vector<CSquare> s_OrthogonalOffsets;
-
 } // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,483 @@
+#include "ChessNNUE.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define CHESS_SIMD_AVAILABLE
+#include <immintrin.h>
+#endif
+
+// GCC and Clang compile the kernels for instruction sets beyond the baseline only when asked per function,
+// MSVC accepts the intrinsics anywhere
+#if defined(CHESS_SIMD_AVAILABLE) && !defined(_MSC_VER)
+#define CHESS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CHESS_TARGET(isa)
+#endif
+
+namespace ChessProj
+{
+
+namespace
+{
+
+// the file starts with this, followed by the arrays of CNNUENetwork in the order of declaration, little-endian
+const char s_FileMagic[8] = { 'C', 'P', 'N', 'N', 'U', 'E', '0', '1' };
+
+const int s_HalfDimensions = CNNUENetwork::s_HalfDimensions;
+const int s_InputSize      = 2 * CNNUENetwork::s_HalfDimensions;
+const int s_HiddenSize     = CNNUENetwork::s_HiddenSize;
+
+// the hidden layer weights are fixed point with 6 fractional bits
+const int s_WeightShift = 6;
+
+// the output is in 1/16 of a centipawn
+const int s_OutputScale = 16;
+
+// indexed by CChessPiece::Type, kings are not features
+const int s_FeaturePieces[7] = { -1, -1, 4, 3, 2, 1, 0 };
+
+enum class SIMD
+{
+    None,
+    SSE41,
+    AVX2
+};
+
+// chosen at runtime like PEXT, so that the same binary runs everywhere
+SIMD DetectSIMD()
+{
+#ifdef CHESS_SIMD_AVAILABLE
+#ifdef _MSC_VER
+    int regs[4];
+
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+
+    __cpuid(regs, 1);
+    const bool isSSE41   = (regs[2] & (1 << 19)) != 0;
+    const bool isOSXSAVE = (regs[2] & (1 << 27)) != 0;
+    const bool isAVX     = (regs[2] & (1 << 28)) != 0;
+
+    bool isAVX2 = false;
+
+    // the OS must save the YMM registers too
+    if (maxLeaf >= 7 && isOSXSAVE && isAVX && (_xgetbv(0) & 6) == 6)
+    {
+        __cpuidex(regs, 7, 0);
+
+        isAVX2 = (regs[1] & (1 << 5)) != 0; // EBX bit 5
+    }
+#else
+    __builtin_cpu_init();
+
+    const bool isAVX2  = __builtin_cpu_supports("avx2");
+    const bool isSSE41 = __builtin_cpu_supports("sse4.1");
+#endif
+
+    if (isAVX2)
+        return SIMD::AVX2;
+
+    if (isSSE41)
+        return SIMD::SSE41;
+#endif
+
+    return SIMD::None;
+}
+
+const SIMD s_SIMD = DetectSIMD();
+
+// accumulator rows: values[i] += row[i] or values[i] -= row[i] for s_HalfDimensions values
+
+#ifdef CHESS_SIMD_AVAILABLE
+
+template <bool IsAdd>
+CHESS_TARGET("avx2")
+void UpdateRowAVX2(std::int16_t * values, const std::int16_t * row)
+{
+    for (int i = 0; i < s_HalfDimensions; i += 16)
+    {
+        auto * dst = reinterpret_cast<__m256i *>(values + i);
+
+        const auto src = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+
+        _mm256_store_si256(dst, IsAdd ? _mm256_add_epi16(_mm256_load_si256(dst), src) : _mm256_sub_epi16(_mm256_load_si256(dst), src));
+    }
+}
+
+// SSE2 is enough here, it is part of x86-64
+template <bool IsAdd>
+void UpdateRowSSE(std::int16_t * values, const std::int16_t * row)
+{
+    for (int i = 0; i < s_HalfDimensions; i += 8)
+    {
+        auto * dst = reinterpret_cast<__m128i *>(values + i);
+
+        const auto src = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+
+        _mm_store_si128(dst, IsAdd ? _mm_add_epi16(_mm_load_si128(dst), src) : _mm_sub_epi16(_mm_load_si128(dst), src));
+    }
+}
+
+#endif
+
+template <bool IsAdd>
+void UpdateRowScalar(std::int16_t * values, const std::int16_t * row)
+{
+    for (int i = 0; i < s_HalfDimensions; ++i)
+        values[i] = static_cast<std::int16_t>(IsAdd ? values[i] + row[i] : values[i] - row[i]);
+}
+
+template <bool IsAdd>
+void UpdateRow(std::int16_t * values, const std::int16_t * row)
+{
+#ifdef CHESS_SIMD_AVAILABLE
+    if (s_SIMD == SIMD::AVX2)
+        return UpdateRowAVX2<IsAdd>(values, row);
+
+    return UpdateRowSSE<IsAdd>(values, row);
+#else
+    return UpdateRowScalar<IsAdd>(values, row);
+#endif
+}
+
+// clipped ReLU of the accumulator into [0, 127], s_HalfDimensions values
+
+#ifdef CHESS_SIMD_AVAILABLE
+
+CHESS_TARGET("avx2")
+void ClipValuesAVX2(const std::int16_t * values, std::uint8_t * out)
+{
+    const auto zero = _mm256_setzero_si256();
+
+    for (int i = 0; i < s_HalfDimensions; i += 32)
+    {
+        const auto a = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i));
+        const auto b = _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i + 16));
+
+        // the pack works within the 128-bit lanes, the permutation puts the quarters back in order
+        const auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_max_epi8(packed, zero));
+    }
+}
+
+CHESS_TARGET("sse4.1")
+void ClipValuesSSE41(const std::int16_t * values, std::uint8_t * out)
+{
+    const auto zero = _mm_setzero_si128();
+
+    for (int i = 0; i < s_HalfDimensions; i += 16)
+    {
+        const auto a = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i));
+        const auto b = _mm_load_si128(reinterpret_cast<const __m128i *>(values + i + 8));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_max_epi8(_mm_packs_epi16(a, b), zero));
+    }
+}
+
+#endif
+
+void ClipValuesScalar(const std::int16_t * values, std::uint8_t * out)
+{
+    for (int i = 0; i < s_HalfDimensions; ++i)
+        out[i] = static_cast<std::uint8_t>(std::min(std::max(static_cast<int>(values[i]), 0), 127));
+}
+
+void ClipValues(const std::int16_t * values, std::uint8_t * out)
+{
+#ifdef CHESS_SIMD_AVAILABLE
+    if (s_SIMD == SIMD::AVX2)
+        return ClipValuesAVX2(values, out);
+
+    if (s_SIMD == SIMD::SSE41)
+        return ClipValuesSSE41(values, out);
+#endif
+
+    ClipValuesScalar(values, out);
+}
+
+// dot product of unsigned 8-bit inputs and signed 8-bit weights, size is a multiple of 32
+
+#ifdef CHESS_SIMD_AVAILABLE
+
+CHESS_TARGET("avx2")
+std::int32_t DotProductAVX2(const std::uint8_t * in, const std::int8_t * weights, const int size)
+{
+    const auto ones = _mm256_set1_epi16(1);
+
+    auto sum = _mm256_setzero_si256();
+
+    for (int i = 0; i < size; i += 32)
+    {
+        const auto products = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i)),
+                                                   _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i)));
+
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+
+    auto sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+
+    return _mm_cvtsi128_si32(sum128);
+}
+
+CHESS_TARGET("sse4.1")
+std::int32_t DotProductSSE41(const std::uint8_t * in, const std::int8_t * weights, const int size)
+{
+    const auto ones = _mm_set1_epi16(1);
+
+    auto sum = _mm_setzero_si128();
+
+    for (int i = 0; i < size; i += 16)
+    {
+        const auto products = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)),
+                                                _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i)));
+
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+
+    return _mm_cvtsi128_si32(sum);
+}
+
+#endif
+
+std::int32_t DotProductScalar(const std::uint8_t * in, const std::int8_t * weights, const int size)
+{
+    std::int32_t sum = 0;
+
+    for (int i = 0; i < size; ++i)
+        sum += static_cast<std::int32_t>(in[i]) * weights[i];
+
+    return sum;
+}
+
+std::int32_t DotProduct(const std::uint8_t * in, const std::int8_t * weights, const int size)
+{
+#ifdef CHESS_SIMD_AVAILABLE
+    if (s_SIMD == SIMD::AVX2)
+        return DotProductAVX2(in, weights, size);
+
+    if (s_SIMD == SIMD::SSE41)
+        return DotProductSSE41(in, weights, size);
+#endif
+
+    return DotProductScalar(in, weights, size);
+}
+
+// a hidden layer followed by the clipped ReLU
+void PropagateHidden(const std::uint8_t * in, const int inSize, const std::int8_t * weights, const std::int32_t * biases, std::uint8_t * out)
+{
+    for (int i = 0; i < s_HiddenSize; ++i)
+    {
+        const std::int32_t value = (biases[i] + DotProduct(in, weights + i * inSize, inSize)) >> s_WeightShift;
+
+        out[i] = static_cast<std::uint8_t>(std::min(std::max(value, 0), 127));
+    }
+}
+
+} // namespace
+
+CNNUENetwork::CNNUENetwork() = default;
+
+bool CNNUENetwork::Load(const char * fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+        return false;
+
+    char magic[sizeof(s_FileMagic)];
+
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, s_FileMagic, sizeof(magic)) != 0)
+        return false;
+
+    // into a separate network, so that a failed load leaves this one intact
+    CNNUENetwork network;
+
+    auto Read = [&file](auto & values, const std::size_t size)
+    {
+        values.resize(size);
+
+        return static_cast<bool>(file.read(reinterpret_cast<char *>(values.data()), size * sizeof(values[0])));
+    };
+
+    if (!Read(network.m_FeatureBiases,  s_HalfDimensions) ||
+        !Read(network.m_FeatureWeights, static_cast<std::size_t>(s_NumFeatures) * s_HalfDimensions) ||
+        !Read(network.m_Hidden1Biases,  s_HiddenSize) ||
+        !Read(network.m_Hidden1Weights, s_HiddenSize * s_InputSize) ||
+        !Read(network.m_Hidden2Biases,  s_HiddenSize) ||
+        !Read(network.m_Hidden2Weights, s_HiddenSize * s_HiddenSize) ||
+        !file.read(reinterpret_cast<char *>(&network.m_OutputBias), sizeof(network.m_OutputBias)) ||
+        !Read(network.m_OutputWeights,  s_HiddenSize))
+        return false;
+
+    if (file.peek() != std::ifstream::traits_type::eof())
+        return false; // a different architecture
+
+    network.m_IsLoaded = true;
+
+    *this = std::move(network);
+
+    return true;
+}
+
+bool CNNUENetwork::IsLoaded() const
+{
+    return m_IsLoaded;
+}
+
+void CNNUENetwork::Refresh(const CChessBoard & board, CNNUEAccumulator & acc) const
+{
+    RefreshPerspective(board, CChessPiece::Color::White, acc);
+    RefreshPerspective(board, CChessPiece::Color::Black, acc);
+}
+
+void CNNUENetwork::Update(const CChessBoard & board, const CChessMove & mv, const CChessPiece & captured,
+                          const CNNUEAccumulator & before, CNNUEAccumulator & after) const
+{
+    struct CFeature
+    {
+        CChessPiece m_Piece;
+        int         m_Index;
+    };
+
+    CFeature removed[3];
+    CFeature added[2];
+
+    int numRemoved = 0;
+    int numAdded   = 0;
+
+    const auto from = mv.GetFrom();
+    const auto to   = mv.GetTo();
+
+    const auto & moved = board.GetPieceAtSquare(to);
+
+    const auto kind = mv.GetKind();
+
+    if (moved.GetType() != CChessPiece::Type::King)
+    {
+        auto movedBefore = moved;
+
+        if (kind == CChessMove::Kind::Promotion)
+            movedBefore.SetType(CChessPiece::Type::Pawn);
+
+        removed[numRemoved++] = { movedBefore, from.GetIndex() };
+        added[numAdded++]     = { moved, to.GetIndex() };
+    }
+
+    if (captured.IsValid())
+        removed[numRemoved++] = { captured, to.GetIndex() };
+
+    if (kind == CChessMove::Kind::EnPassant)
+    {
+        const CChessPiece pawn(CChessPiece::Type::Pawn, CChessPiece::GetOppositeColor(moved.GetColor()));
+
+        removed[numRemoved++] = { pawn, CSquare(from.GetRank(), to.GetFile()).GetIndex() };
+    }
+    else
+    if (kind == CChessMove::Kind::Castling)
+    {
+        const bool isKingSide = to.GetFile() > from.GetFile();
+
+        const CChessPiece rook(CChessPiece::Type::Rook, moved.GetColor());
+
+        removed[numRemoved++] = { rook, CSquare(from.GetRank(), isKingSide ? 7 : 0).GetIndex() };
+        added[numAdded++]     = { rook, CSquare(from.GetRank(), isKingSide ? 5 : 3).GetIndex() };
+    }
+
+    for (const auto perspective : {CChessPiece::Color::White, CChessPiece::Color::Black})
+    {
+        // the features of the side whose king moved are all different
+        if (moved.GetType() == CChessPiece::Type::King && moved.GetColor() == perspective)
+        {
+            RefreshPerspective(board, perspective, after);
+
+            continue;
+        }
+
+        const int p = static_cast<int>(perspective);
+
+        auto * values = after.m_Values[p];
+
+        std::memcpy(values, before.m_Values[p], sizeof(after.m_Values[p]));
+
+        const auto & kingSquare = (perspective == CChessPiece::Color::White) ? board.GetWhiteKingPos() : board.GetBlackKingPos();
+
+        const int kingIndex = kingSquare.GetIndex();
+
+        for (int i = 0; i < numRemoved; ++i)
+            UpdateRow<false>(values, &m_FeatureWeights[GetFeatureIndex(perspective, kingIndex, removed[i].m_Piece, removed[i].m_Index) * s_HalfDimensions]);
+
+        for (int i = 0; i < numAdded; ++i)
+            UpdateRow<true>(values, &m_FeatureWeights[GetFeatureIndex(perspective, kingIndex, added[i].m_Piece, added[i].m_Index) * s_HalfDimensions]);
+    }
+}
+
+int CNNUENetwork::Evaluate(const CNNUEAccumulator & acc, const CChessPiece::Color sideToMove) const
+{
+    alignas(32) std::uint8_t input[s_InputSize];
+    alignas(32) std::uint8_t hidden1[s_HiddenSize];
+    alignas(32) std::uint8_t hidden2[s_HiddenSize];
+
+    // the side to move comes first
+    ClipValues(acc.m_Values[static_cast<int>(sideToMove)], input);
+    ClipValues(acc.m_Values[static_cast<int>(CChessPiece::GetOppositeColor(sideToMove))], input + s_HalfDimensions);
+
+    PropagateHidden(input,   s_InputSize,  m_Hidden1Weights.data(), m_Hidden1Biases.data(), hidden1);
+    PropagateHidden(hidden1, s_HiddenSize, m_Hidden2Weights.data(), m_Hidden2Biases.data(), hidden2);
+
+    const std::int32_t output = m_OutputBias + DotProduct(hidden2, m_OutputWeights.data(), s_HiddenSize);
+
+    return output / s_OutputScale;
+}
+
+const char * CNNUENetwork::GetSIMDName()
+{
+    switch (s_SIMD)
+    {
+    case SIMD::AVX2:  return "AVX2";
+    case SIMD::SSE41: return "SSE4.1";
+    case SIMD::None:  break;
+    }
+
+    return "scalar";
+}
+
+void CNNUENetwork::RefreshPerspective(const CChessBoard & board, const CChessPiece::Color perspective, CNNUEAccumulator & acc) const
+{
+    auto * values = acc.m_Values[static_cast<int>(perspective)];
+
+    std::copy(m_FeatureBiases.begin(), m_FeatureBiases.end(), values);
+
+    const auto & kingSquare = (perspective == CChessPiece::Color::White) ? board.GetWhiteKingPos() : board.GetBlackKingPos();
+
+    const int kingIndex = kingSquare.GetIndex();
+
+    for (auto pieces = board.GetOccupiedBB() & ~board.GetTypeBB(CChessPiece::Type::King); pieces; )
+    {
+        const int index = PopLSB(pieces);
+
+        const int feature = GetFeatureIndex(perspective, kingIndex, board.GetPieceAtIndex(index), index);
+
+        UpdateRow<true>(values, &m_FeatureWeights[feature * s_HalfDimensions]);
+    }
+}
+
+int CNNUENetwork::GetFeatureIndex(const CChessPiece::Color perspective, const int kingIndex, const CChessPiece & piece, const int index)
+{
+    // black sees the board flipped vertically, so that both sides play up the board
+    const int flip = (perspective == CChessPiece::Color::White) ? 0 : 56;
+
+    const int pieceIndex = s_FeaturePieces[static_cast<int>(piece.GetType())] * 2 + ((piece.GetColor() == perspective) ? 0 : 1);
+
+    return ((kingIndex ^ flip) * 10 + pieceIndex) * 64 + (index ^ flip);
+}
+
+} // namespace ChessProj
\ No newline at end of file
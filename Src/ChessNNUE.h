@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ChessBoard.h"
+#include "ChessMove.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ChessProj
+{
+
+// the first layer outputs of a position for both perspectives, indexed by CChessPiece::Color
+struct CNNUEAccumulator
+{
+    alignas(32) std::int16_t m_Values[2][256];
+};
+
+// NNUE evaluation: a HalfKP feature transformer, whose output is kept in an accumulator updated by every move,
+// followed by small int8 layers with clipped ReLU activations: 2 x 256 -> 32 -> 32 -> 1.
+// The network is read-only once loaded and can be shared by the search threads
+class CNNUENetwork
+{
+public:
+    // HalfKP: the square of the own king x the type, color and square of a non-king piece, from each side's point of view
+    static const int s_NumFeatures    = 64 * 10 * 64;
+    static const int s_HalfDimensions = 256;
+    static const int s_HiddenSize     = 32;
+
+    CNNUENetwork();
+
+    // reads the weights, returns false (leaving the network unloaded) for a missing or malformed file
+    bool Load(const char * fileName);
+
+    bool IsLoaded() const;
+
+    // computes the accumulator from all the pieces on the board
+    void Refresh(const CChessBoard & board, CNNUEAccumulator & acc) const;
+
+    // the accumulator after the move from the one before it. The board is the position after the move,
+    // captured is the piece the move took from its destination square (see CUndoInfo)
+    void Update(const CChessBoard & board, const CChessMove & mv, const CChessPiece & captured,
+                const CNNUEAccumulator & before, CNNUEAccumulator & after) const;
+
+    // centipawns from the point of view of the side to move
+    int Evaluate(const CNNUEAccumulator & acc, const CChessPiece::Color sideToMove) const;
+
+    // which kernels run: "AVX2", "SSE4.1" or "scalar"
+    static const char * GetSIMDName();
+
+private:
+    void RefreshPerspective(const CChessBoard & board, const CChessPiece::Color perspective, CNNUEAccumulator & acc) const;
+
+    static int GetFeatureIndex(const CChessPiece::Color perspective, const int kingIndex, const CChessPiece & piece, const int index);
+
+    bool                        m_IsLoaded = false;
+
+    std::vector<std::int16_t>   m_FeatureBiases;    // [s_HalfDimensions]
+    std::vector<std::int16_t>   m_FeatureWeights;   // [s_NumFeatures][s_HalfDimensions]
+
+    std::vector<std::int32_t>   m_Hidden1Biases;    // [s_HiddenSize]
+    std::vector<std::int8_t>    m_Hidden1Weights;   // [s_HiddenSize][2 * s_HalfDimensions]
+
+    std::vector<std::int32_t>   m_Hidden2Biases;    // [s_HiddenSize]
+    std::vector<std::int8_t>    m_Hidden2Weights;   // [s_HiddenSize][s_HiddenSize]
+
+    std::int32_t                m_OutputBias = 0;
+    std::vector<std::int8_t>    m_OutputWeights;    // [s_HiddenSize]
+};
+
+} // namespace ChessProj
\ No newline at end of file
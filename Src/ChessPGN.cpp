@@ -0,0 +1,392 @@
+#include "ChessPGN.h"
+#include "ChessMappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace ChessProj
+{
+
+namespace
+{
+
+// the files smaller than this are not worth splitting
+const std::size_t s_MinChunkSize = 1 << 20;
+
+// every game starts with its Event tag (the seven tag roster order)
+const char s_GameStart[] = "\n[Event ";
+
+bool IsSpace(const char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+bool IsDigit(const char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+// the end of a SAN token or of a termination marker
+bool IsTokenEnd(const char ch)
+{
+    return IsSpace(ch) || ch == '{' || ch == '}' || ch == '(' || ch == ')' || ch == '[' || ch == ']' || ch == ';' || ch == '$';
+}
+
+const char * SkipToLineEnd(const char * ch, const char * end)
+{
+    const auto * lineEnd = static_cast<const char *>(std::memchr(ch, '\n', end - ch));
+
+    return lineEnd ? lineEnd + 1 : end;
+}
+
+const char * SkipComment(const char * ch, const char * end)
+{
+    const auto * commentEnd = static_cast<const char *>(std::memchr(ch, '}', end - ch));
+
+    return commentEnd ? commentEnd + 1 : end;
+}
+
+// ch points after the opening parenthesis, nested variations and comments in them are skipped too
+const char * SkipVariation(const char * ch, const char * end)
+{
+    int depth = 1;
+
+    while (ch < end && depth > 0)
+    {
+        switch (*ch)
+        {
+        case '(': ++depth; ++ch; break;
+        case ')': --depth; ++ch; break;
+        case '{': ch = SkipComment(ch + 1, end); break;
+        case ';': ch = SkipToLineEnd(ch, end); break;
+        default:  ++ch;
+        }
+    }
+
+    return ch;
+}
+
+// the start of the first game at or after pos, or end
+const char * FindGameStart(const char * begin, const char * pos, const char * end)
+{
+    const std::size_t patternSize = sizeof(s_GameStart) - 1;
+
+    // the pattern includes the newline before the tag
+    if (pos > begin)
+        --pos;
+
+    while (static_cast<std::size_t>(end - pos) >= patternSize)
+    {
+        const auto * newLine = static_cast<const char *>(std::memchr(pos, '\n', end - pos));
+
+        if (!newLine || static_cast<std::size_t>(end - newLine) < patternSize)
+            break;
+
+        if (std::memcmp(newLine, s_GameStart, patternSize) == 0)
+            return newLine + 1;
+
+        pos = newLine + 1;
+    }
+
+    return end;
+}
+
+// the game being read: the position is replayed as the moves come
+class CGameReader
+{
+public:
+    CGameReader(const PGNGameCallback & callback, CPGNStats & stats)
+        : m_Callback(callback)
+        , m_Stats(stats)
+    {
+        m_Game.m_Moves.reserve(256);
+    }
+
+    bool IsInGame() const
+    {
+        return m_IsInGame;
+    }
+
+    bool HasMoves() const
+    {
+        return !m_Game.m_Moves.empty();
+    }
+
+    void Start()
+    {
+        m_IsInGame = true;
+        m_IsValid  = true;
+
+        m_Game.m_StartPosition.StartNew();
+        m_Game.m_Moves.clear();
+        m_Game.m_Result = CPGNGame::Result::Unknown;
+
+        m_Position = m_Game.m_StartPosition;
+    }
+
+    void SetFEN(const char * fen)
+    {
+        if (!m_Game.m_StartPosition.SetFEN(fen))
+            m_IsValid = false;
+
+        m_Position = m_Game.m_StartPosition;
+    }
+
+    void AddMove(const char * san, const std::size_t length)
+    {
+        if (!m_IsValid)
+            return;
+
+        const auto mv = m_Position.GetMoveBySAN(san, length);
+
+        if (!mv.IsValid())
+        {
+            m_IsValid = false;
+
+            return;
+        }
+
+        m_Position.Move(mv, mv.GetPromotion());
+
+        m_Game.m_Moves.push_back(mv);
+    }
+
+    void Finish(const CPGNGame::Result result)
+    {
+        if (!m_IsInGame)
+            return;
+
+        m_IsInGame = false;
+
+        if (!m_IsValid)
+        {
+            ++m_Stats.m_NumInvalidGames;
+
+            return;
+        }
+
+        m_Game.m_Result = result;
+
+        ++m_Stats.m_NumGames;
+
+        m_Stats.m_NumMoves += m_Game.m_Moves.size();
+
+        m_Callback(m_Game);
+    }
+
+private:
+    const PGNGameCallback &     m_Callback;
+    CPGNStats &                 m_Stats;
+    CPGNGame                    m_Game;
+    CChessGame                  m_Position;
+    bool                        m_IsInGame = false;
+    bool                        m_IsValid  = true;
+};
+
+// ch points after '[', returns the position after the tag
+const char * ParseTag(const char * ch, const char * end, CGameReader & reader)
+{
+    const auto * nameBegin = ch;
+
+    while (ch < end && !IsSpace(*ch) && *ch != '"' && *ch != ']')
+        ++ch;
+
+    const auto nameLength = static_cast<std::size_t>(ch - nameBegin);
+
+    while (ch < end && *ch != '"' && *ch != ']' && *ch != '\n')
+        ++ch;
+
+    // a FEN is the only value needed, it fits easily
+    char value[128];
+    std::size_t valueLength = 0;
+
+    if (ch < end && *ch == '"')
+    {
+        for (++ch; ch < end && *ch != '"' && *ch != '\n'; ++ch)
+        {
+            if (*ch == '\\' && ch + 1 < end)
+                ++ch;
+
+            if (valueLength < sizeof(value) - 1)
+                value[valueLength++] = *ch;
+        }
+    }
+
+    value[valueLength] = '\0';
+
+    if (nameLength == 3 && std::memcmp(nameBegin, "FEN", 3) == 0)
+        reader.SetFEN(value);
+
+    // the rest of the line
+    while (ch < end && *ch != ']' && *ch != '\n')
+        ++ch;
+
+    return (ch < end && *ch == ']') ? ch + 1 : ch;
+}
+
+} // namespace
+
+void ParsePGN(const char * begin, const char * end, const PGNGameCallback & callback, CPGNStats & stats)
+{
+    CGameReader reader(callback, stats);
+
+    const char * ch = begin;
+
+    while (ch < end)
+    {
+        const char c = *ch;
+
+        if (IsSpace(c))
+        {
+            ++ch;
+
+            continue;
+        }
+
+        switch (c)
+        {
+        case '[':
+            // a tag after the moves starts the next game, the previous one had no termination marker
+            if (reader.IsInGame() && reader.HasMoves())
+                reader.Finish(CPGNGame::Result::Unknown);
+
+            if (!reader.IsInGame())
+                reader.Start();
+
+            ch = ParseTag(ch + 1, end, reader);
+            continue;
+
+        case '{':
+            ch = SkipComment(ch + 1, end);
+            continue;
+
+        case ';':
+            ch = SkipToLineEnd(ch, end);
+            continue;
+
+        case '(':
+            ch = SkipVariation(ch + 1, end);
+            continue;
+
+        case '$':
+            for (++ch; ch < end && IsDigit(*ch); ++ch) {}
+            continue;
+
+        case '%':
+            // an escaped line
+            if (ch == begin || ch[-1] == '\n')
+            {
+                ch = SkipToLineEnd(ch, end);
+
+                continue;
+            }
+
+            break;
+
+        case ')':
+        case ']':
+        case '}':
+            ++ch; // stray
+            continue;
+        }
+
+        const auto * token = ch;
+
+        // a move number, possibly followed by the move without a space: "12.", "12...", "1.e4"
+        if (IsDigit(c))
+        {
+            while (ch < end && IsDigit(*ch))
+                ++ch;
+
+            if (ch < end && *ch == '.')
+            {
+                while (ch < end && *ch == '.')
+                    ++ch;
+
+                continue;
+            }
+        }
+
+        while (ch < end && !IsTokenEnd(*ch))
+            ++ch;
+
+        const auto length = static_cast<std::size_t>(ch - token);
+
+        if (length == 3 && std::memcmp(token, "1-0", 3) == 0)
+            reader.Finish(CPGNGame::Result::WhiteWon);
+        else
+        if (length == 3 && std::memcmp(token, "0-1", 3) == 0)
+            reader.Finish(CPGNGame::Result::BlackWon);
+        else
+        if (length == 7 && std::memcmp(token, "1/2-1/2", 7) == 0)
+            reader.Finish(CPGNGame::Result::Draw);
+        else
+        if (length == 1 && token[0] == '*')
+            reader.Finish(CPGNGame::Result::Unknown);
+        else
+        if (length == 4 && std::memcmp(token, "e.p.", 4) == 0)
+            continue; // the old en passant annotation
+        else
+        {
+            // movetext without tags
+            if (!reader.IsInGame())
+                reader.Start();
+
+            reader.AddMove(token, length);
+        }
+    }
+
+    reader.Finish(CPGNGame::Result::Unknown);
+}
+
+bool ReadPGNFile(const char * fileName, const PGNGameCallback & callback, CPGNStats & stats, int numThreads /*= 0*/)
+{
+    CMappedFile file;
+    if (!file.Open(fileName))
+        return false;
+
+    const char * begin = file.GetData();
+    const char * end   = begin + file.GetSize();
+
+    if (numThreads <= 0)
+        numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    numThreads = static_cast<int>(std::min<std::size_t>(numThreads, file.GetSize() / s_MinChunkSize + 1));
+
+    // the chunks start at games, a chunk may end up empty if a game spans the whole of it
+    std::vector<const char *> bounds;
+    bounds.push_back(begin);
+
+    for (int i = 1; i < numThreads; ++i)
+    {
+        const auto * pos = begin + file.GetSize() / numThreads * i;
+
+        bounds.push_back(std::max(FindGameStart(begin, std::max(pos, bounds.back()), end), bounds.back()));
+    }
+
+    bounds.push_back(end);
+
+    std::vector<CPGNStats> chunkStats(numThreads);
+
+    std::vector<std::thread> threads;
+
+    for (int i = 1; i < numThreads; ++i)
+        threads.emplace_back([&, i]() { ParsePGN(bounds[i], bounds[i + 1], callback, chunkStats[i]); });
+
+    ParsePGN(bounds[0], bounds[1], callback, chunkStats[0]);
+
+    for (auto & thread : threads)
+        thread.join();
+
+    for (const auto & chunk : chunkStats)
+    {
+        stats.m_NumGames        += chunk.m_NumGames;
+        stats.m_NumInvalidGames += chunk.m_NumInvalidGames;
+        stats.m_NumMoves        += chunk.m_NumMoves;
+    }
+
+    return true;
+}
+
+} // namespace ChessProj
\ No newline at end of file
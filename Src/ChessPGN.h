@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ChessGame.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace ChessProj
+{
+
+// a game read from PGN, replayed and validated move by move
+struct CPGNGame
+{
+    enum class Result
+    {
+        WhiteWon,
+        BlackWon,
+        Draw,
+        Unknown     // "*" or no termination marker
+    };
+
+    CChessGame              m_StartPosition;    // from the FEN tag, or the standard start position
+    std::vector<CChessMove> m_Moves;            // legal in sequence, with the kinds set
+    Result                  m_Result = Result::Unknown;
+};
+
+struct CPGNStats
+{
+    std::uint64_t   m_NumGames        = 0;  // passed to the callback
+    std::uint64_t   m_NumInvalidGames = 0;  // with an illegal or unreadable move, or a bad FEN tag
+    std::uint64_t   m_NumMoves        = 0;  // of the valid games
+};
+
+// the game is only valid during the call, it is reused for the next one
+using PGNGameCallback = std::function<void(const CPGNGame & game)>;
+
+// parses the games of the text in a single thread. Variations, comments and NAGs are skipped,
+// a game with an invalid move is counted and dropped
+void ParsePGN(const char * begin, const char * end, const PGNGameCallback & callback, CPGNStats & stats);
+
+// maps the file and parses it in chunks split at game boundaries, one thread per chunk (0 threads = one per
+// hardware thread). The callback is called concurrently from those threads. Returns false if the file can't be mapped
+bool ReadPGNFile(const char * fileName, const PGNGameCallback & callback, CPGNStats & stats, int numThreads = 0);
+
+} // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "ChessPackedPosition.h"
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+#include <vector>
+
+namespace ChessProj
+{
+
+namespace
+{
+
+// the ranges smaller than this are not worth a thread
+const std::size_t s_MinPositionsPerThread = 4096;
+
+} // namespace
+
+bool CPackedPositionFile::Open(const char * fileName)
+{
+    if (!m_File.Open(fileName))
+        return false;
+
+    if (m_File.GetSize() % sizeof(CPackedPosition) != 0)
+    {
+        m_File.Close();
+
+        return false;
+    }
+
+    return true;
+}
+
+void CPackedPositionFile::Close()
+{
+    m_File.Close();
+}
+
+bool CPackedPositionFile::IsOpen() const
+{
+    return m_File.IsOpen();
+}
+
+std::size_t CPackedPositionFile::GetNumPositions() const
+{
+    return m_File.GetSize() / sizeof(CPackedPosition);
+}
+
+const CPackedPosition & CPackedPositionFile::GetPackedPosition(const std::size_t index) const
+{
+    assert(index < GetNumPositions());
+
+    // the record is all bytes, so it has no alignment requirement
+    return reinterpret_cast<const CPackedPosition *>(m_File.GetData())[index];
+}
+
+bool CPackedPositionFile::GetPosition(const std::size_t index, CChessGame & game) const
+{
+    return game.SetPackedPosition(GetPackedPosition(index));
+}
+
+void DecodePackedPositions(const CPackedPositionFile & file, const std::size_t begin, const std::size_t end,
+                           const PackedPositionCallback & callback, CPackedPositionStats & stats, int numThreads /*= 0*/)
+{
+    assert(begin <= end && end <= file.GetNumPositions());
+
+    const std::size_t numPositions = end - begin;
+
+    if (numThreads <= 0)
+        numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    numThreads = static_cast<int>(std::min<std::size_t>(numThreads, numPositions / s_MinPositionsPerThread + 1));
+
+    std::vector<CPackedPositionStats> rangeStats(numThreads);
+
+    auto DecodeRange = [&](const int i)
+    {
+        const std::size_t rangeBegin = begin + numPositions * i / numThreads;
+        const std::size_t rangeEnd   = begin + numPositions * (i + 1) / numThreads;
+
+        auto & range = rangeStats[i];
+
+        CChessGame game;
+
+        for (std::size_t index = rangeBegin; index < rangeEnd; ++index)
+        {
+            if (!file.GetPosition(index, game))
+            {
+                ++range.m_NumInvalidPositions;
+
+                continue;
+            }
+
+            ++range.m_NumPositions;
+
+            callback(index, game);
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int i = 1; i < numThreads; ++i)
+        threads.emplace_back(DecodeRange, i);
+
+    DecodeRange(0);
+
+    for (auto & thread : threads)
+        thread.join();
+
+    for (const auto & range : rangeStats)
+    {
+        stats.m_NumPositions        += range.m_NumPositions;
+        stats.m_NumInvalidPositions += range.m_NumInvalidPositions;
+    }
+}
+
+bool ReadPackedPositionFile(const char * fileName, const PackedPositionCallback & callback, CPackedPositionStats & stats,
+                            int numThreads /*= 0*/)
+{
+    CPackedPositionFile file;
+    if (!file.Open(fileName))
+        return false;
+
+    DecodePackedPositions(file, 0, file.GetNumPositions(), callback, stats, numThreads);
+
+    return true;
+}
+
+} // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "ChessGame.h"
+#include "ChessMappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace ChessProj
+{
+
+// a position in a fixed 32 bytes, for datasets too big for FEN text (see CChessGame::GetPackedPosition).
+// Made of bytes only, with the multi-byte values little-endian, so the records can be read in place from a mapped file
+// of any endianness and alignment
+struct CPackedPosition
+{
+    std::uint8_t    m_Occupied[8]       = {};   // bitboard of the occupied squares
+    std::uint8_t    m_Pieces[16]        = {};   // a nibble per occupied square from a1 up, the low nibble first
+    std::uint8_t    m_HalfMoveClock[2]  = {};
+    std::uint8_t    m_FullMoveNumber[2] = {};
+    std::uint8_t    m_UserData[4]       = {};   // not part of the position, free for the dataset (e.g. a score and the game result)
+};
+
+static_assert(sizeof(CPackedPosition) == 32, "a packed position must take 32 bytes");
+
+struct CPackedPositionStats
+{
+    std::uint64_t   m_NumPositions        = 0;  // passed to the callback
+    std::uint64_t   m_NumInvalidPositions = 0;  // rejected by CChessGame::SetPackedPosition
+};
+
+// the game is only valid during the call, it is reused for the next one
+using PackedPositionCallback = std::function<void(std::size_t index, const CChessGame & game)>;
+
+// a file of packed positions, mapped into memory. A file is just the records back to back, so a position is found
+// by its index and a file can be split or concatenated at any record boundary
+class CPackedPositionFile
+{
+public:
+    // returns false if the file can't be mapped or its size is not a whole number of records
+    bool Open(const char * fileName);
+
+    void Close();
+
+    bool IsOpen() const;
+
+    std::size_t GetNumPositions() const;
+
+    const CPackedPosition & GetPackedPosition(const std::size_t index) const;
+
+    // returns false for an invalid record, leaving the game unchanged
+    bool GetPosition(const std::size_t index, CChessGame & game) const;
+
+private:
+    CMappedFile     m_File;
+};
+
+// decodes the positions [begin, end) of the file in contiguous ranges, one thread per range (0 threads = one per
+// hardware thread). The callback is called concurrently from those threads, the invalid records are counted and skipped
+void DecodePackedPositions(const CPackedPositionFile & file, const std::size_t begin, const std::size_t end,
+                           const PackedPositionCallback & callback, CPackedPositionStats & stats, int numThreads = 0);
+
+// maps the file and decodes all its positions, returns false if the file can't be opened
+bool ReadPackedPositionFile(const char * fileName, const PackedPositionCallback & callback, CPackedPositionStats & stats,
+                            int numThreads = 0);
+
+} // namespace ChessProj
\ No newline at end of file
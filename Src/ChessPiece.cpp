@@ -3,22 +3,23 @@
 namespace ChessProj
 {
 
+static_assert(sizeof(CChessPiece) == 1, "a piece must fit in a byte");
+
 CChessPiece::CChessPiece(const Type type /*= Type::None*/, const Color color /*= Color::White*/)
-    : m_Type(type)
-    , m_Color(color)
+    : m_Code(static_cast<std::uint8_t>(static_cast<int>(type) | static_cast<int>(color) << s_ColorShift))
 {
 }
 
 bool CChessPiece::IsValid() const
 {
-    return m_Type != Type::None;
+    return (m_Code & s_TypeMask) != 0;
 }
 
 char CChessPiece::GetFENChar() const
 {
-    const bool isWhite = m_Color == Color::White;
+    const bool isWhite = GetColor() == Color::White;
 
-    switch (m_Type)
+    switch (GetType())
     {
     case Type::Pawn :   return isWhite ? 'P' : 'p';
     case Type::Knight : return isWhite ? 'N' : 'n';
@@ -30,24 +31,45 @@ char CChessPiece::GetFENChar() const
     return isWhite ? 'K' : 'k';
 }
 
+CChessPiece CChessPiece::FromFENChar(const char ch)
+{
+    switch (ch)
+    {
+    case 'P' : return CChessPiece(Type::Pawn,   Color::White);
+    case 'N' : return CChessPiece(Type::Knight, Color::White);
+    case 'B' : return CChessPiece(Type::Bishop, Color::White);
+    case 'R' : return CChessPiece(Type::Rook,   Color::White);
+    case 'Q' : return CChessPiece(Type::Queen,  Color::White);
+    case 'K' : return CChessPiece(Type::King,   Color::White);
+    case 'p' : return CChessPiece(Type::Pawn,   Color::Black);
+    case 'n' : return CChessPiece(Type::Knight, Color::Black);
+    case 'b' : return CChessPiece(Type::Bishop, Color::Black);
+    case 'r' : return CChessPiece(Type::Rook,   Color::Black);
+    case 'q' : return CChessPiece(Type::Queen,  Color::Black);
+    case 'k' : return CChessPiece(Type::King,   Color::Black);
+    }
+
+    return CChessPiece();
+}
+
 CChessPiece::Type CChessPiece::GetType() const
 {
-    return m_Type;
+    return static_cast<Type>(m_Code & s_TypeMask);
 }
 
 void CChessPiece::SetType(const Type type)
 {
-    m_Type = type;
+    m_Code = static_cast<std::uint8_t>((m_Code & ~s_TypeMask) | static_cast<int>(type));
 }
 
 CChessPiece::Color CChessPiece::GetColor() const
 {
-    return m_Color;
+    return static_cast<Color>(m_Code >> s_ColorShift);
 }
 
 void CChessPiece::SetColor(const Color color)
 {
-    m_Color = color;
+    m_Code = static_cast<std::uint8_t>((m_Code & s_TypeMask) | static_cast<int>(color) << s_ColorShift);
 }
 
 CChessPiece::Color CChessPiece::GetOppositeColor(const Color color)
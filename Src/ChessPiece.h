@@ -1,12 +1,15 @@
 #pragma once
 
+#include <cstdint>
+
 namespace ChessProj
 {
 
+// packed into one byte: the type in the low 3 bits, the color in the next one
 class CChessPiece
 {
 public:
-    enum class Type
+    enum class Type : std::uint8_t
     {
         None,
         King,
@@ -17,7 +20,7 @@ public:
         Pawn
     };
 
-    enum class Color
+    enum class Color : std::uint8_t
     {
         White,
         Black
@@ -29,6 +32,9 @@ public:
 
     char GetFENChar() const;
 
+    // returns an invalid piece for a character that doesn't denote a piece
+    static CChessPiece FromFENChar(const char ch);
+
     Type GetType() const;
     void SetType(const Type type);
 
@@ -38,8 +44,10 @@ public:
     static Color GetOppositeColor(const Color color);
 
 private:
-    Type    m_Type;
-    Color   m_Color;
+    static const int    s_TypeMask   = 7;
+    static const int    s_ColorShift = 3;
+
+    std::uint8_t        m_Code;
 };
 
 } // namespace ChessProj
\ No newline at end of file
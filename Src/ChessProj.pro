@@ -8,24 +8,18 @@ CONFIG(debug, debug|release) {
         DESTDIR = ../bin/release/
 }
 
+include(ChessCore.pri)
+
 SOURCES     +=  ChessProj.cpp                   \
                 MainWindow.cpp                  \
                 MainToolBar.cpp                 \
                 ActionManager.cpp               \
-                ChessBoardGraphicsView.cpp      \
-                ChessBoard.cpp                  \
-                ChessGame.cpp                   \
-                ChessMove.cpp                   \
-                ChessPiece.cpp
+                ChessBoardGraphicsView.cpp
 
 HEADERS     +=  MainWindow.h                    \
                 MainToolBar.h                   \
                 ActionManager.h                 \
-                ChessBoardGraphicsView.h        \
-                ChessBoard.h                    \
-                ChessGame.h                     \
-                ChessMove.h                     \
-                ChessPiece.h
+                ChessBoardGraphicsView.h
 
 RESOURCES   =   ChessProj.qrc
 
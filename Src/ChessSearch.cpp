@@ -0,0 +1,728 @@
+#include "ChessSearch.h"
+#include "ChessEval.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace ChessProj
+{
+
+namespace
+{
+
+const int s_Infinity = 32000;
+
+// for the move ordering, indexed by CChessPiece::Type
+const int s_PieceValues[] = { 0, 0, 900, 500, 330, 320, 100 };
+
+int GetPieceValue(const CChessPiece::Type type)
+{
+    return s_PieceValues[static_cast<int>(type)];
+}
+
+// mate scores are stored relative to the node, not to the root
+int ToTransTableScore(const int score, const int ply)
+{
+    if (CSearch::IsMateScore(score))
+        return (score > 0) ? score + ply : score - ply;
+
+    return score;
+}
+
+int FromTransTableScore(const int score, const int ply)
+{
+    if (CSearch::IsMateScore(score))
+        return (score > 0) ? score - ply : score + ply;
+
+    return score;
+}
+
+// moves the best scored of the remaining moves to the position and returns it
+const CChessMove & PickMove(const CMoveList & moves, int * scores, std::uint8_t * order, const std::size_t pos)
+{
+    std::size_t best = pos;
+
+    for (std::size_t i = pos + 1; i < moves.GetSize(); ++i)
+        if (scores[i] > scores[best])
+            best = i;
+
+    std::swap(scores[pos], scores[best]);
+    std::swap(order[pos], order[best]);
+
+    return moves[order[pos]];
+}
+
+// a table mate within the search horizon is scored as the mate it is. A longer one scores below the mate scores
+// but above any evaluation, by its distance from the node, so it doesn't depend on the ply in the transposition table
+int GetTablebaseScore(const CTablebases::Outcome outcome, const int plies, const int ply)
+{
+    if (outcome == CTablebases::Outcome::Draw)
+        return 0;
+
+    const int score = (ply + plies < CSearch::s_MaxPly) ? CSearch::s_MateScore - ply - plies : CSearch::s_MateScore - CSearch::s_MaxPly - 1 - plies;
+
+    return (outcome == CTablebases::Outcome::Win) ? score : -score;
+}
+
+} // namespace
+
+CSearch::CSearch(CTransTable & transTable)
+    : m_TransTable(transTable)
+    , m_Nodes(0)
+    , m_IsStopped(false)
+    , m_IsStopRequested(false)
+{
+}
+
+CSearchResult CSearch::Search(const CChessGame & game, const CSearchLimits & limits, const std::vector<std::uint64_t> & gameHashes /*= {}*/)
+{
+    m_IsStopped = false;
+    m_Nodes     = 0;
+
+    return Run(game, limits, gameHashes);
+}
+
+CSearchResult CSearch::Run(const CChessGame & game, const CSearchLimits & limits, const std::vector<std::uint64_t> & gameHashes)
+{
+    m_Game = game;
+    m_Game.SetTransTable(&m_TransTable);
+
+    assert(gameHashes.empty() || gameHashes.back() == game.GetHash());
+
+    // the root is m_Hashes[0], the positions before it are kept as far back as they can repeat
+    const std::size_t numGameHashes = gameHashes.empty() ? 0 : std::min(gameHashes.size() - 1, static_cast<std::size_t>(game.GetHalfMoveClock()));
+
+    m_GameHashes.assign(gameHashes.end() - 1 - numGameHashes, gameHashes.end() - 1);
+
+    m_Limits    = limits;
+    m_StartTime = std::chrono::steady_clock::now();
+
+    m_TablebaseHits = 0;
+
+    std::fill(&m_Killers[0][0], &m_Killers[0][0] + s_MaxPly * 2, CChessMove());
+    std::fill(&m_History[0][0], &m_History[0][0] + 64 * 64, 0);
+
+    if (m_Network)
+        m_Network->Refresh(m_Game.GetBoard(), m_Accumulators[0]);
+
+    if (m_ThreadIndex == 0)
+        m_TransTable.NewSearch();
+
+    CSearchResult result;
+
+    CMoveList moves;
+    m_Game.GenerateLegalMoves(moves);
+
+    if (moves.IsEmpty())
+    {
+        result.m_Score = m_Game.IsKingUnderCheck() ? -s_MateScore : 0;
+
+        return result;
+    }
+
+    // something to play even if the first iteration is interrupted
+    result.m_BestMove = moves[0];
+
+    const int maxDepth = std::min(std::max(limits.m_MaxDepth, 1), s_MaxPly - 1);
+
+    for (int depth = 1; depth <= maxDepth; ++depth)
+    {
+        if (IsDepthSkipped(depth))
+            continue;
+
+        const int score = SearchNode(-s_Infinity, s_Infinity, depth, 0);
+
+        if (m_IsStopped)
+            break; // the interrupted iteration is discarded
+
+        result.m_Score = score;
+        result.m_Depth = depth;
+        result.m_PV.assign(m_PV[0], m_PV[0] + m_PVLength[0]);
+
+        if (!result.m_PV.empty())
+            result.m_BestMove = result.m_PV.front();
+
+        if (m_ProgressCallback)
+        {
+            result.m_Nodes         = GetTotalNodes();
+            result.m_TablebaseHits = m_TablebaseHits;
+            result.m_Seconds       = GetElapsedSeconds();
+
+            m_ProgressCallback(result);
+        }
+
+        // a deeper search can't find a shorter mate
+        if (IsMateScore(score) && s_MateScore - std::abs(score) <= depth)
+            break;
+
+        // the next iteration would most likely not finish in the remaining time
+        if (m_Limits.m_MaxTimeMs > 0 && GetElapsedSeconds() * 1000.0 * 2.0 > m_Limits.m_MaxTimeMs)
+            break;
+    }
+
+    result.m_Nodes         = GetTotalNodes();
+    result.m_TablebaseHits = m_TablebaseHits;
+    result.m_Seconds       = GetElapsedSeconds();
+
+    return result;
+}
+
+void CSearch::Stop()
+{
+    m_IsStopRequested = true;
+}
+
+void CSearch::ResetStop()
+{
+    m_IsStopRequested = false;
+}
+
+void CSearch::SetNetwork(const CNNUENetwork * network)
+{
+    m_Network = (network && network->IsLoaded()) ? network : nullptr;
+}
+
+void CSearch::SetTablebases(const CTablebases * tablebases)
+{
+    m_Tablebases = tablebases;
+}
+
+void CSearch::SetProgressCallback(ProgressCallback callback)
+{
+    m_ProgressCallback = std::move(callback);
+}
+
+bool CSearch::IsDepthSkipped(const int depth) const
+{
+    if (m_ThreadIndex == 0)
+        return false;
+
+    // helper i searches the depths of a pattern of its own, so that the threads spread over the next few depths
+    static const int s_SkipSize[]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+    static const int s_SkipPhase[] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+    const int idx = (m_ThreadIndex - 1) % 20;
+
+    return ((depth + s_SkipPhase[idx]) / s_SkipSize[idx]) % 2 != 0;
+}
+
+bool CSearch::IsMateScore(const int score)
+{
+    return std::abs(score) > s_MateScore - s_MaxPly;
+}
+
+std::string CSearch::GetScoreText(const int score)
+{
+    char text[16];
+
+    if (IsMateScore(score))
+    {
+        const int plies = s_MateScore - std::abs(score);
+
+        std::snprintf(text, sizeof(text), "%sM%d", (score > 0) ? "" : "-", (plies + 1) / 2);
+    }
+    else
+        std::snprintf(text, sizeof(text), "%+.2f", score / 100.0);
+
+    return text;
+}
+
+int CSearch::SearchNode(int alpha, int beta, int depth, const int ply)
+{
+    m_PVLength[ply] = ply;
+
+    const bool isPV = beta - alpha > 1;
+
+    if (ply > 0)
+    {
+        if (m_Game.GetHalfMoveClock() >= 100 || IsRepetition(ply))
+            return 0;
+
+        // no line from here can be better than a mate at this ply
+        alpha = std::max(alpha, -s_MateScore + ply);
+        beta  = std::min(beta,   s_MateScore - ply - 1);
+
+        if (alpha >= beta)
+            return alpha;
+
+        CTablebases::Outcome outcome;
+
+        int plies = 0;
+
+        if (m_Tablebases && m_Tablebases->Probe(m_Game, outcome, plies))
+        {
+            ++m_TablebaseHits;
+
+            return GetTablebaseScore(outcome, plies, ply);
+        }
+    }
+
+    const bool isInCheck = m_Game.IsKingUnderCheck();
+
+    if (isInCheck)
+        ++depth; // check extension
+
+    if (depth <= 0)
+        return Quiescence(alpha, beta, ply);
+
+    if (ply >= s_MaxPly - 1)
+        return EvaluatePosition(ply);
+
+    CountNode();
+
+    if (IsTimeToStop())
+        return 0;
+
+    const auto hash = m_Game.GetHash();
+
+    m_Hashes[ply] = hash;
+
+    CChessMove ttMove;
+
+    CTransTable::CEntry entry;
+
+    if (m_TransTable.Probe(hash, entry))
+    {
+        ttMove = entry.m_Move;
+
+        const int score = FromTransTableScore(entry.m_Score, ply);
+
+        if (!isPV && entry.m_Depth >= depth &&
+            (entry.m_Bound == CTransTable::Bound::Exact ||
+             (entry.m_Bound == CTransTable::Bound::Lower && score >= beta) ||
+             (entry.m_Bound == CTransTable::Bound::Upper && score <= alpha)))
+            return score;
+    }
+
+    CMoveList moves;
+    m_Game.GenerateLegalMoves(moves);
+
+    if (moves.IsEmpty())
+        return isInCheck ? -s_MateScore + ply : 0;
+
+    int scores[CMoveList::s_MaxMoves];
+    std::uint8_t order[CMoveList::s_MaxMoves];
+
+    ScoreMoves(moves, scores, ttMove, ply);
+
+    for (std::size_t i = 0; i < moves.GetSize(); ++i)
+        order[i] = static_cast<std::uint8_t>(i);
+
+    const int oldAlpha = alpha;
+
+    int bestScore = -s_Infinity;
+
+    CChessMove bestMove;
+
+    CUndoInfo undo;
+
+    for (std::size_t i = 0; i < moves.GetSize(); ++i)
+    {
+        const auto & mv = PickMove(moves, scores, order, i);
+
+        const bool isQuiet = GetCaptureScore(mv) == 0 && mv.GetPromotion() == CChessPiece::Type::None;
+
+        MakeMove(mv, undo, ply);
+
+        int score;
+
+        if (i == 0)
+            score = -SearchNode(-beta, -alpha, depth - 1, ply + 1);
+        else
+        {
+            // late quiet moves are searched shallower first, and again at full depth if they turn out good
+            int reduction = 0;
+
+            if (depth >= 3 && i >= 3 && isQuiet && !isInCheck && !m_Game.IsKingUnderCheck())
+                reduction = (i >= 8) ? 2 : 1;
+
+            score = -SearchNode(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1);
+
+            if (score > alpha && reduction > 0)
+                score = -SearchNode(-alpha - 1, -alpha, depth - 1, ply + 1);
+
+            if (score > alpha && score < beta)
+                score = -SearchNode(-beta, -alpha, depth - 1, ply + 1);
+        }
+
+        m_Game.UnmakeMove(mv, undo);
+
+        if (m_IsStopped)
+            return 0;
+
+        if (score <= bestScore)
+            continue;
+
+        bestScore = score;
+        bestMove  = mv;
+
+        if (score <= alpha)
+            continue;
+
+        alpha = score;
+
+        UpdatePV(ply, mv);
+
+        if (alpha >= beta)
+        {
+            if (isQuiet)
+                UpdateQuietMoveStats(mv, depth, ply);
+
+            break;
+        }
+    }
+
+    const auto bound = (bestScore >= beta)     ? CTransTable::Bound::Lower :
+                       (bestScore > oldAlpha)  ? CTransTable::Bound::Exact :
+                                                 CTransTable::Bound::Upper;
+
+    m_TransTable.Store(hash, bestMove, ToTransTableScore(bestScore, ply), std::min(depth, 127), bound);
+
+    return bestScore;
+}
+
+int CSearch::Quiescence(int alpha, const int beta, const int ply)
+{
+    m_PVLength[ply] = ply;
+
+    CountNode();
+
+    if (IsTimeToStop())
+        return 0;
+
+    if (ply >= s_MaxPly - 1)
+        return EvaluatePosition(ply);
+
+    const bool isInCheck = m_Game.IsKingUnderCheck();
+
+    int bestScore = -s_Infinity;
+
+    CMoveList moves;
+
+    if (isInCheck)
+    {
+        // all evasions, otherwise a mate would be missed
+        m_Game.GenerateLegalMoves(moves);
+
+        if (moves.IsEmpty())
+            return -s_MateScore + ply;
+    }
+    else
+    {
+        // the side to move can usually do at least as well as the static evaluation by not capturing
+        bestScore = EvaluatePosition(ply);
+
+        if (bestScore >= beta)
+            return bestScore;
+
+        alpha = std::max(alpha, bestScore);
+
+        m_Game.GenerateLegalCaptures(moves);
+    }
+
+    int scores[CMoveList::s_MaxMoves];
+    std::uint8_t order[CMoveList::s_MaxMoves];
+
+    ScoreMoves(moves, scores, CChessMove(), ply);
+
+    for (std::size_t i = 0; i < moves.GetSize(); ++i)
+        order[i] = static_cast<std::uint8_t>(i);
+
+    CUndoInfo undo;
+
+    for (std::size_t i = 0; i < moves.GetSize(); ++i)
+    {
+        const auto & mv = PickMove(moves, scores, order, i);
+
+        MakeMove(mv, undo, ply);
+
+        const int score = -Quiescence(-beta, -alpha, ply + 1);
+
+        m_Game.UnmakeMove(mv, undo);
+
+        if (m_IsStopped)
+            return 0;
+
+        if (score <= bestScore)
+            continue;
+
+        bestScore = score;
+
+        if (score <= alpha)
+            continue;
+
+        alpha = score;
+
+        UpdatePV(ply, mv);
+
+        if (alpha >= beta)
+            break;
+    }
+
+    return bestScore;
+}
+
+int CSearch::EvaluatePosition(const int ply) const
+{
+    if (!m_Network)
+        return Evaluate(m_Game);
+
+    const int score = m_Network->Evaluate(m_Accumulators[ply], m_Game.GetCurrentMoveColor());
+
+    // an untrained network can be far off, but must not be taken for a mate
+    return std::min(std::max(score, -s_MateScore + s_MaxPly + 1), s_MateScore - s_MaxPly - 1);
+}
+
+// makes the move and brings the accumulator of the next ply up to date
+void CSearch::MakeMove(const CChessMove & mv, CUndoInfo & undo, const int ply)
+{
+    m_Game.MakeMove(mv, undo);
+
+    if (m_Network)
+        m_Network->Update(m_Game.GetBoard(), mv, undo.m_Captured, m_Accumulators[ply], m_Accumulators[ply + 1]);
+}
+
+bool CSearch::IsRepetition(const int ply) const
+{
+    const auto hash = m_Game.GetHash();
+
+    // only the positions since the last capture or pawn move can repeat, and only with the same side to move.
+    // The negative plies are the positions played before the root
+    const int numGameHashes = static_cast<int>(m_GameHashes.size());
+
+    const int firstPly = std::max(-numGameHashes, ply - m_Game.GetHalfMoveClock());
+
+    for (int i = ply - 4; i >= firstPly; i -= 2)
+        if (((i >= 0) ? m_Hashes[i] : m_GameHashes[numGameHashes + i]) == hash)
+            return true;
+
+    return false;
+}
+
+bool CSearch::IsTimeToStop()
+{
+    if (m_IsStopped.load(std::memory_order_relaxed))
+        return true;
+
+    if (m_IsStopRequested.load(std::memory_order_relaxed))
+        m_IsStopped = true;
+
+    const auto nodes = m_Nodes.load(std::memory_order_relaxed);
+
+    // the clock and the helpers' counts are read once per 1024 nodes
+    if (m_Limits.m_MaxNodes > 0 && (m_Helpers.empty() || (nodes & 1023) == 0) && GetTotalNodes() >= m_Limits.m_MaxNodes)
+        m_IsStopped = true;
+
+    if (m_Limits.m_MaxTimeMs > 0 && (nodes & 1023) == 0 && GetElapsedSeconds() * 1000.0 >= m_Limits.m_MaxTimeMs)
+        m_IsStopped = true;
+
+    return m_IsStopped.load(std::memory_order_relaxed);
+}
+
+void CSearch::CountNode()
+{
+    // a plain increment, the other threads only read the count
+    m_Nodes.store(m_Nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+std::uint64_t CSearch::GetTotalNodes() const
+{
+    auto nodes = m_Nodes.load(std::memory_order_relaxed);
+
+    for (const auto * helper : m_Helpers)
+        nodes += helper->m_Nodes.load(std::memory_order_relaxed);
+
+    return nodes;
+}
+
+void CSearch::ScoreMoves(const CMoveList & moves, int * scores, const CChessMove & ttMove, const int ply) const
+{
+    for (std::size_t i = 0; i < moves.GetSize(); ++i)
+    {
+        const auto & mv = moves[i];
+
+        const int captureScore = GetCaptureScore(mv);
+
+        if (mv == ttMove)
+            scores[i] = 1000000;
+        else if (captureScore > 0)
+            scores[i] = 200000 + captureScore;
+        else if (mv.GetPromotion() != CChessPiece::Type::None)
+            scores[i] = 150000 + GetPieceValue(mv.GetPromotion());
+        else if (mv == m_Killers[ply][0])
+            scores[i] = 100001;
+        else if (mv == m_Killers[ply][1])
+            scores[i] = 100000;
+        else
+            scores[i] = m_History[mv.GetFrom().GetIndex()][mv.GetTo().GetIndex()];
+    }
+}
+
+int CSearch::GetCaptureScore(const CChessMove & mv) const
+{
+    const auto & board = m_Game.GetBoard();
+
+    const auto attacker = board.GetPieceAtSquare(mv.GetFrom()).GetType();
+
+    auto victim = board.GetPieceAtSquare(mv.GetTo()).GetType();
+
+    if (victim == CChessPiece::Type::None)
+    {
+        if (mv.GetKind() != CChessMove::Kind::EnPassant)
+            return 0;
+
+        victim = CChessPiece::Type::Pawn;
+    }
+
+    // most valuable victim, least valuable attacker
+    return GetPieceValue(victim) * 10 - GetPieceValue(attacker) / 10 + 100;
+}
+
+void CSearch::UpdatePV(const int ply, const CChessMove & mv)
+{
+    m_PV[ply][ply] = mv;
+
+    for (int i = ply + 1; i < m_PVLength[ply + 1]; ++i)
+        m_PV[ply][i] = m_PV[ply + 1][i];
+
+    m_PVLength[ply] = std::max(m_PVLength[ply + 1], ply + 1);
+}
+
+void CSearch::UpdateQuietMoveStats(const CChessMove & mv, const int depth, const int ply)
+{
+    if (mv != m_Killers[ply][0])
+    {
+        m_Killers[ply][1] = m_Killers[ply][0];
+        m_Killers[ply][0] = mv;
+    }
+
+    int & history = m_History[mv.GetFrom().GetIndex()][mv.GetTo().GetIndex()];
+
+    history += depth * depth;
+
+    // history scores stay below the killers
+    if (history > 50000)
+        for (auto & fromRow : m_History)
+            for (auto & value : fromRow)
+                value /= 2;
+}
+
+double CSearch::GetElapsedSeconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
+}
+
+// CParallelSearch
+
+CParallelSearch::CParallelSearch(CTransTable & transTable, const int numThreads /*= 0*/)
+    : m_TransTable(transTable)
+{
+    SetNumThreads(numThreads);
+}
+
+void CParallelSearch::SetNumThreads(int numThreads)
+{
+    if (numThreads <= 0)
+        numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    m_Searches.resize(numThreads);
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        if (!m_Searches[i])
+            m_Searches[i].reset(new CSearch(m_TransTable));
+
+        m_Searches[i]->m_ThreadIndex = i;
+        m_Searches[i]->SetNetwork(m_Network);
+        m_Searches[i]->SetTablebases(m_Tablebases);
+    }
+
+    m_Searches[0]->m_Helpers.clear();
+
+    for (int i = 1; i < numThreads; ++i)
+        m_Searches[0]->m_Helpers.push_back(m_Searches[i].get());
+}
+
+int CParallelSearch::GetNumThreads() const
+{
+    return static_cast<int>(m_Searches.size());
+}
+
+CSearchResult CParallelSearch::Search(const CChessGame & game, const CSearchLimits & limits, const std::vector<std::uint64_t> & gameHashes /*= {}*/)
+{
+    // the limit flags and the node counts, cleared before any thread starts, so that the end of the main search
+    // can't be missed by a helper that starts late, nor its count of the previous search read. The stop requests
+    // are cleared by ResetStop() only
+    for (auto & search : m_Searches)
+    {
+        search->m_IsStopped = false;
+        search->m_Nodes     = 0;
+    }
+
+    CSearchLimits helperLimits;
+    helperLimits.m_MaxDepth = limits.m_MaxDepth;
+
+    std::vector<std::thread> helpers;
+
+    for (std::size_t i = 1; i < m_Searches.size(); ++i)
+    {
+        auto * search = m_Searches[i].get();
+
+        helpers.emplace_back([search, &game, &helperLimits, &gameHashes]() { search->Run(game, helperLimits, gameHashes); });
+    }
+
+    auto result = m_Searches[0]->Run(game, limits, gameHashes);
+
+    // not a stop request, which would stay until ResetStop()
+    for (std::size_t i = 1; i < m_Searches.size(); ++i)
+        m_Searches[i]->m_IsStopped = true;
+
+    for (auto & helper : helpers)
+        helper.join();
+
+    // the helpers have finished, so the count is final
+    result.m_Nodes = m_Searches[0]->GetTotalNodes();
+
+    for (std::size_t i = 1; i < m_Searches.size(); ++i)
+        result.m_TablebaseHits += m_Searches[i]->m_TablebaseHits;
+
+    return result;
+}
+
+void CParallelSearch::Stop()
+{
+    for (auto & search : m_Searches)
+        search->Stop();
+}
+
+void CParallelSearch::ResetStop()
+{
+    for (auto & search : m_Searches)
+        search->ResetStop();
+}
+
+void CParallelSearch::SetNetwork(const CNNUENetwork * network)
+{
+    m_Network = network;
+
+    for (auto & search : m_Searches)
+        search->SetNetwork(network);
+}
+
+void CParallelSearch::SetTablebases(const CTablebases * tablebases)
+{
+    m_Tablebases = tablebases;
+
+    for (auto & search : m_Searches)
+        search->SetTablebases(tablebases);
+}
+
+void CParallelSearch::SetProgressCallback(CSearch::ProgressCallback callback)
+{
+    m_Searches[0]->SetProgressCallback(std::move(callback));
+}
+
+} // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "ChessGame.h"
+#include "ChessNNUE.h"
+#include "ChessTablebase.h"
+#include "ChessTransTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ChessProj
+{
+
+struct CSearchLimits
+{
+    int             m_MaxDepth  = 64;
+    std::uint64_t   m_MaxNodes  = 0;    // 0 = no limit
+    int             m_MaxTimeMs = 0;    // 0 = no limit
+};
+
+struct CSearchResult
+{
+    CChessMove              m_BestMove;             // invalid if there are no legal moves
+    std::vector<CChessMove> m_PV;
+    int                     m_Score         = 0;    // centipawns for the side to move
+    int                     m_Depth         = 0;    // the last completed iteration
+    std::uint64_t           m_Nodes         = 0;
+    std::uint64_t           m_TablebaseHits = 0;
+    double                  m_Seconds       = 0.0;
+};
+
+// iterative deepening principal variation search
+class CSearch
+{
+public:
+    static const int s_MaxPly    = 64;
+    static const int s_MateScore = 30000;   // mate at the root, a mate in n plies scores s_MateScore - n
+
+    // called by the searching thread after every completed iteration, with the result so far
+    using ProgressCallback = std::function<void(const CSearchResult & result)>;
+
+    explicit CSearch(CTransTable & transTable);
+
+    // gameHashes are the hashes of the positions of the game up to the searched one (the last), for the repetitions
+    // of the positions played before the root. Those before the last capture or pawn move may be left out
+    CSearchResult Search(const CChessGame & game, const CSearchLimits & limits, const std::vector<std::uint64_t> & gameHashes = {});
+
+    // stops the running search as soon as possible, can be called from another thread
+    void Stop();
+
+    // clears the stop of the previous search. A caller running the search on another thread calls it before
+    // starting the thread, so that a Stop() coming right after can't be lost
+    void ResetStop();
+
+    // evaluates with the network instead of the handcrafted evaluation, nullptr switches back.
+    // The network must stay loaded while a search runs
+    void SetNetwork(const CNNUENetwork * network);
+
+    // probes the tables below the root, nullptr switches them off. The tables must stay loaded while a search runs
+    void SetTablebases(const CTablebases * tablebases);
+
+    void SetProgressCallback(ProgressCallback callback);
+
+    static bool IsMateScore(const int score);
+
+    // "+0.35", "-1.20", "M3" or "-M2" (mate in moves, not plies)
+    static std::string GetScoreText(const int score);
+
+private:
+    friend class CParallelSearch;
+
+    CSearchResult Run(const CChessGame & game, const CSearchLimits & limits, const std::vector<std::uint64_t> & gameHashes);
+
+    bool IsDepthSkipped(const int depth) const;
+
+    int SearchNode(int alpha, int beta, int depth, const int ply);
+    int Quiescence(int alpha, const int beta, const int ply);
+
+    // the static evaluation of the position at the ply, for the side to move
+    int EvaluatePosition(const int ply) const;
+
+    void MakeMove(const CChessMove & mv, CUndoInfo & undo, const int ply);
+
+    bool IsRepetition(const int ply) const;
+
+    bool IsTimeToStop();
+
+    // only the searching thread writes m_Nodes, the main search of a CParallelSearch reads the helpers' counts
+    void CountNode();
+
+    // of this search and its helpers
+    std::uint64_t GetTotalNodes() const;
+
+    void ScoreMoves(const CMoveList & moves, int * scores, const CChessMove & ttMove, const int ply) const;
+
+    int GetCaptureScore(const CChessMove & mv) const;
+
+    void UpdatePV(const int ply, const CChessMove & mv);
+
+    void UpdateQuietMoveStats(const CChessMove & mv, const int depth, const int ply);
+
+    double GetElapsedSeconds() const;
+
+    CTransTable &                           m_TransTable;
+    CChessGame                              m_Game;
+    CSearchLimits                           m_Limits;
+    std::chrono::steady_clock::time_point   m_StartTime;
+    std::atomic<std::uint64_t>              m_Nodes;
+    std::atomic<bool>                       m_IsStopped;                    // by a limit or a stop request, cleared by every search
+    std::atomic<bool>                       m_IsStopRequested;              // by Stop(), cleared only by ResetStop()
+    int                                     m_ThreadIndex = 0;  // 0 for the main thread, helpers skip some depths
+    std::vector<const CSearch *>            m_Helpers;          // of the main thread, their nodes count in the limit and the reports
+    const CNNUENetwork *                    m_Network = nullptr;
+    const CTablebases *                     m_Tablebases = nullptr;
+    std::uint64_t                           m_TablebaseHits = 0;
+    ProgressCallback                        m_ProgressCallback;
+
+    std::uint64_t                           m_Hashes[s_MaxPly];             // positions on the current path, for repetitions
+    std::vector<std::uint64_t>              m_GameHashes;                   // positions played before the root, the oldest first
+    CChessMove                              m_PV[s_MaxPly][s_MaxPly];       // triangular principal variation table
+    int                                     m_PVLength[s_MaxPly];
+    CChessMove                              m_Killers[s_MaxPly][2];         // quiet moves that caused a cutoff at the ply
+    int                                     m_History[64][64];              // quiet move cutoffs by [from][to]
+    CNNUEAccumulator                        m_Accumulators[s_MaxPly];       // of the positions on the current path, with a network
+};
+
+// Lazy SMP: every thread searches the same root with its own copy of the game and its own heuristics,
+// the threads help each other only through the shared transposition table
+class CParallelSearch
+{
+public:
+    // 0 threads = one per hardware thread
+    explicit CParallelSearch(CTransTable & transTable, const int numThreads = 0);
+
+    // must not be called during a search
+    void SetNumThreads(int numThreads);
+    int GetNumThreads() const;
+
+    // the calling thread runs the main search, which alone checks the limits, the node limit against the nodes
+    // of all the threads. The helpers are stopped and joined when it finishes, the result is the main search's one
+    // with the nodes of all the threads.
+    // See CSearch::Search for gameHashes
+    CSearchResult Search(const CChessGame & game, const CSearchLimits & limits, const std::vector<std::uint64_t> & gameHashes = {});
+
+    // can be called from another thread
+    void Stop();
+
+    // see CSearch::ResetStop
+    void ResetStop();
+
+    // for all the threads, see CSearch::SetNetwork
+    void SetNetwork(const CNNUENetwork * network);
+
+    // for all the threads, see CSearch::SetTablebases
+    void SetTablebases(const CTablebases * tablebases);
+
+    // reported by the main search only, with the nodes of all the threads
+    void SetProgressCallback(CSearch::ProgressCallback callback);
+
+private:
+    CTransTable &                           m_TransTable;
+    std::vector<std::unique_ptr<CSearch>>   m_Searches;
+    const CNNUENetwork *                    m_Network = nullptr;
+    const CTablebases *                     m_Tablebases = nullptr;
+};
+
+} // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,1137 @@
+#include "ChessTablebase.h"
+#include "ChessMappedFile.h"
+#include "ChessTables.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace ChessProj
+{
+
+// the pieces of a table in index order: the strong king, the lone king, then the other strong pieces sorted by type
+struct CTablebaseMaterial
+{
+    int                 m_NumPieces = 2;
+    CChessPiece::Type   m_Types[CTablebases::s_MaxPieces] = { CChessPiece::Type::King, CChessPiece::Type::King };
+    int                 m_Sizes[CTablebases::s_MaxPieces] = {};     // the number of index values of every piece
+    bool                m_HasPawns  = false;
+    std::uint64_t       m_Size      = 0;                            // of the index, with either side to move
+    std::string         m_Signature;
+};
+
+namespace
+{
+
+// a position of a table, the strong side is white
+struct CPosition
+{
+    int     m_Squares[CTablebases::s_MaxPieces] = {};   // in the piece order of the material
+    bool    m_IsStrongToMove = true;
+};
+
+// a move into a position of the same table or, by a capture or a promotion, into one of another table
+struct CMoveResult
+{
+    CPosition           m_Position;
+    int                 m_Captured  = -1;   // the piece taken
+    int                 m_Promoted  = -1;   // the pawn promoted
+    CChessPiece::Type   m_Promotion = CChessPiece::Type::None;
+
+    bool IsConversion() const
+    {
+        return m_Captured >= 0 || m_Promoted >= 0;
+    }
+};
+
+// the values of the generation: the plies to mate + 1, positive for a win of the side to move and negative for a
+// loss, 0 for a draw. The files keep the magnitude only, as the parity of the plies tells a win from a loss
+const int s_Unknown = -32768;
+const int s_Invalid = -32767;
+
+const char          s_FileMagic[8]  = { 'C', 'P', 'T', 'B', '0', '0', '0', '1' };
+const std::size_t   s_HeaderSize    = 24;   // the magic, the bits per value (32 bits), reserved (32 bits) and the number of values (64 bits)
+const std::size_t   s_FilePadding   = 8;    // so a value is read without checking the end of the file
+const char *        s_FileExtension = ".cptb";
+
+// the work of a generation pass is handed out to the threads in chunks of indices
+const std::uint64_t s_ChunkSize = 4096;
+
+// the signature letters, indexed by CChessPiece::Type
+const char s_PieceLetters[] = " KQRBNP";
+
+const CChessPiece::Type s_PromotionTypes[] =
+{
+    CChessPiece::Type::Queen,
+    CChessPiece::Type::Rook,
+    CChessPiece::Type::Bishop,
+    CChessPiece::Type::Knight
+};
+
+// the symmetries of the board: bit 0 mirrors the files, bit 1 the ranks and bit 2 the diagonal a1-h8. The tables
+// with pawns only use the mirroring of the files
+struct CSymmetryTables
+{
+    constexpr CSymmetryTables()
+        : m_Squares(), m_KingIndices(), m_PawnKingIndices(), m_KingSquares(), m_PawnKingSquares()
+    {
+        for (int symmetry = 0; symmetry < 8; ++symmetry)
+            for (int square = 0; square < 64; ++square)
+            {
+                int rank = square / 8;
+                int file = square % 8;
+
+                if (symmetry & 1)
+                    file = 7 - file;
+
+                if (symmetry & 2)
+                    rank = 7 - rank;
+
+                if (symmetry & 4)
+                {
+                    const int temp = rank;
+
+                    rank = file;
+                    file = temp;
+                }
+
+                m_Squares[symmetry][square] = rank * 8 + file;
+            }
+
+        int numKingSquares = 0;
+
+        for (int square = 0; square < 64; ++square)
+        {
+            const int rank = square / 8;
+            const int file = square % 8;
+
+            m_KingIndices[square]     = -1;
+            m_PawnKingIndices[square] = -1;
+
+            if (file < 4 && rank <= file)
+            {
+                m_KingIndices[square] = numKingSquares;
+                m_KingSquares[numKingSquares++] = square;
+            }
+
+            if (file < 4)
+            {
+                m_PawnKingIndices[square] = rank * 4 + file;
+                m_PawnKingSquares[rank * 4 + file] = square;
+            }
+        }
+    }
+
+    int m_Squares[8][64];       // [symmetry][square]
+    int m_KingIndices[64];      // of the strong king without pawns: the triangle a1-d1-d4, -1 outside
+    int m_PawnKingIndices[64];  // of the strong king with pawns: the files a-d, -1 outside
+    int m_KingSquares[10];
+    int m_PawnKingSquares[32];
+};
+
+constexpr CSymmetryTables s_Symmetry;
+
+static_assert(s_Symmetry.m_Squares[7][1] == 55, "symmetries");
+static_assert(s_Symmetry.m_KingSquares[9] == 27 && s_Symmetry.m_PawnKingSquares[31] == 59, "king squares");
+
+void WriteLittleEndian(std::uint8_t * bytes, const int numBytes, std::uint64_t value)
+{
+    for (int i = 0; i < numBytes; ++i, value >>= 8)
+        bytes[i] = static_cast<std::uint8_t>(value);
+}
+
+std::uint64_t ReadLittleEndian(const std::uint8_t * bytes, const int numBytes)
+{
+    std::uint64_t value = 0;
+
+    for (int i = numBytes - 1; i >= 0; --i)
+        value = (value << 8) | bytes[i];
+
+    return value;
+}
+
+int GetWinValue(const int plies)
+{
+    return plies + 1;
+}
+
+int GetLossValue(const int plies)
+{
+    return -(plies + 1);
+}
+
+int GetPlies(const int value)
+{
+    return std::abs(value) - 1;
+}
+
+// the value of a move into a position of the value, for the side that makes it
+int GetParentValue(const int value)
+{
+    if (value > 0)
+        return -(value + 1);
+
+    if (value < 0)
+        return -value + 1;
+
+    return 0;
+}
+
+// orders the values for the side to move: the fastest win first and the slowest loss last but one, before the fastest
+int GetValueRank(const int value)
+{
+    if (value > 0)
+        return 100000 - value;
+
+    if (value < 0)
+        return -100000 - value;
+
+    return 0;
+}
+
+// the material of the pieces besides the kings, in any order. False for a king or more pieces than a table takes
+bool SetMaterial(CTablebaseMaterial & material, const CChessPiece::Type * types, const int numTypes)
+{
+    if (numTypes < 0 || numTypes + 2 > CTablebases::s_MaxPieces)
+        return false;
+
+    material = CTablebaseMaterial();
+
+    material.m_NumPieces = numTypes + 2;
+
+    for (int i = 0; i < numTypes; ++i)
+    {
+        if (types[i] == CChessPiece::Type::None || types[i] == CChessPiece::Type::King)
+            return false;
+
+        material.m_Types[i + 2] = types[i];
+    }
+
+    std::sort(material.m_Types + 2, material.m_Types + material.m_NumPieces);
+
+    material.m_Signature = "K";
+
+    for (int i = 2; i < material.m_NumPieces; ++i)
+    {
+        material.m_Signature += s_PieceLetters[static_cast<int>(material.m_Types[i])];
+
+        if (material.m_Types[i] == CChessPiece::Type::Pawn)
+            material.m_HasPawns = true;
+    }
+
+    material.m_Signature += 'K';
+
+    material.m_Sizes[0] = material.m_HasPawns ? 32 : 10;
+    material.m_Sizes[1] = 64;
+
+    for (int i = 2; i < material.m_NumPieces; ++i)
+        material.m_Sizes[i] = (material.m_Types[i] == CChessPiece::Type::Pawn) ? 48 : 64;
+
+    material.m_Size = 2;
+
+    for (int i = 0; i < material.m_NumPieces; ++i)
+        material.m_Size *= material.m_Sizes[i];
+
+    return true;
+}
+
+// e.g. "KRK" or "KBNK", the pieces in any order
+bool ParseSignature(const char * signature, CTablebaseMaterial & material)
+{
+    const std::size_t length = std::strlen(signature);
+
+    if (length < 2 || length > CTablebases::s_MaxPieces || signature[0] != 'K' || signature[length - 1] != 'K')
+        return false;
+
+    CChessPiece::Type types[CTablebases::s_MaxPieces];
+
+    int numTypes = 0;
+
+    for (std::size_t i = 1; i + 1 < length; ++i)
+    {
+        const char * letter = std::strchr(s_PieceLetters + 2, signature[i]);
+        if (!letter || *letter == 0)
+            return false;
+
+        types[numTypes++] = static_cast<CChessPiece::Type>(letter - s_PieceLetters);
+    }
+
+    return SetMaterial(material, types, numTypes);
+}
+
+std::uint64_t GetOrientedIndex(const CTablebaseMaterial & material, const CPosition & position)
+{
+    const int * kingIndices = material.m_HasPawns ? s_Symmetry.m_PawnKingIndices : s_Symmetry.m_KingIndices;
+
+    std::uint64_t index = position.m_IsStrongToMove ? 0 : 1;
+
+    index = index * material.m_Sizes[0] + kingIndices[position.m_Squares[0]];
+
+    for (int i = 1; i < material.m_NumPieces; ++i)
+        index = index * material.m_Sizes[i] + ((material.m_Types[i] == CChessPiece::Type::Pawn) ? position.m_Squares[i] - 8 : position.m_Squares[i]);
+
+    return index;
+}
+
+// the index of the position in any orientation: by the symmetry that takes the strong king into its squares, with the
+// pieces of a type in ascending order. Of two such symmetries (the king on the diagonal) the smaller index is taken
+std::uint64_t GetIndex(const CTablebaseMaterial & material, const CPosition & position)
+{
+    const int * kingIndices = material.m_HasPawns ? s_Symmetry.m_PawnKingIndices : s_Symmetry.m_KingIndices;
+
+    const int numSymmetries = material.m_HasPawns ? 2 : 8;
+
+    std::uint64_t result = ~std::uint64_t(0);
+
+    for (int symmetry = 0; symmetry < numSymmetries; ++symmetry)
+    {
+        const int * squares = s_Symmetry.m_Squares[symmetry];
+
+        if (kingIndices[squares[position.m_Squares[0]]] < 0)
+            continue;
+
+        CPosition oriented;
+        oriented.m_IsStrongToMove = position.m_IsStrongToMove;
+
+        for (int i = 0; i < material.m_NumPieces; ++i)
+            oriented.m_Squares[i] = squares[position.m_Squares[i]];
+
+        for (int i = 3; i < material.m_NumPieces; ++i)
+            for (int j = i; j > 2 && material.m_Types[j - 1] == material.m_Types[j] && oriented.m_Squares[j - 1] > oriented.m_Squares[j]; --j)
+                std::swap(oriented.m_Squares[j - 1], oriented.m_Squares[j]);
+
+        result = std::min(result, GetOrientedIndex(material, oriented));
+    }
+
+    return result;
+}
+
+void DecodeIndex(const CTablebaseMaterial & material, std::uint64_t index, CPosition & position)
+{
+    for (int i = material.m_NumPieces - 1; i > 0; --i)
+    {
+        const int value = static_cast<int>(index % material.m_Sizes[i]);
+
+        index /= material.m_Sizes[i];
+
+        position.m_Squares[i] = (material.m_Types[i] == CChessPiece::Type::Pawn) ? value + 8 : value;
+    }
+
+    const int king = static_cast<int>(index % material.m_Sizes[0]);
+
+    position.m_Squares[0]      = material.m_HasPawns ? s_Symmetry.m_PawnKingSquares[king] : s_Symmetry.m_KingSquares[king];
+    position.m_IsStrongToMove  = index < static_cast<std::uint64_t>(material.m_Sizes[0]);
+}
+
+Bitboard GetAttacks(const CChessPiece::Type type, const int square, const Bitboard occupied)
+{
+    switch (type)
+    {
+    case CChessPiece::Type::King:
+        return GetKingAttacks(square);
+
+    case CChessPiece::Type::Queen:
+        return GetQueenAttacks(square, occupied);
+
+    case CChessPiece::Type::Rook:
+        return GetRookAttacks(square, occupied);
+
+    case CChessPiece::Type::Bishop:
+        return GetBishopAttacks(square, occupied);
+
+    case CChessPiece::Type::Knight:
+        return GetKnightAttacks(square);
+
+    case CChessPiece::Type::Pawn:
+        return GetPawnAttacks(square, CChessPiece::Color::White);
+
+    default:
+        return 0;
+    }
+}
+
+Bitboard GetOccupied(const CTablebaseMaterial & material, const CPosition & position)
+{
+    Bitboard occupied = 0;
+
+    for (int i = 0; i < material.m_NumPieces; ++i)
+        occupied |= GetSquareBB(position.m_Squares[i]);
+
+    return occupied;
+}
+
+// whether a strong piece, but the excluded one, attacks the square
+bool IsAttackedByStrong(const CTablebaseMaterial & material, const CPosition & position, const int square, const Bitboard occupied, const int excluded = -1)
+{
+    for (int i = 0; i < material.m_NumPieces; ++i)
+        if (i != 1 && i != excluded && (GetAttacks(material.m_Types[i], position.m_Squares[i], occupied) & GetSquareBB(square)))
+            return true;
+
+    return false;
+}
+
+// a square of its own for every piece, no pawn on the first or the last rank, the kings apart and the lone king not in
+// check with the strong side to move
+bool IsLegalPosition(const CTablebaseMaterial & material, const CPosition & position)
+{
+    Bitboard occupied = 0;
+
+    for (int i = 0; i < material.m_NumPieces; ++i)
+    {
+        const int square = position.m_Squares[i];
+
+        if (occupied & GetSquareBB(square))
+            return false;
+
+        if (material.m_Types[i] == CChessPiece::Type::Pawn && (square < 8 || square >= 56))
+            return false;
+
+        occupied |= GetSquareBB(square);
+    }
+
+    if (GetKingAttacks(position.m_Squares[0]) & GetSquareBB(position.m_Squares[1]))
+        return false;
+
+    return !position.m_IsStrongToMove || !IsAttackedByStrong(material, position, position.m_Squares[1], occupied);
+}
+
+// calls visit with every legal move of the side to move
+template <typename Visit>
+void ForEachMove(const CTablebaseMaterial & material, const CPosition & position, Visit visit)
+{
+    const Bitboard occupied = GetOccupied(material, position);
+
+    CMoveResult result;
+    result.m_Position = position;
+    result.m_Position.m_IsStrongToMove = !position.m_IsStrongToMove;
+
+    auto & squares = result.m_Position.m_Squares;
+
+    if (position.m_IsStrongToMove)
+    {
+        // the lone king is never in check here, so every move but one next to it is legal
+        for (int i = 0; i < material.m_NumPieces; ++i)
+        {
+            if (i == 1)
+                continue;
+
+            const int from = position.m_Squares[i];
+
+            const bool isPawn = material.m_Types[i] == CChessPiece::Type::Pawn;
+
+            Bitboard targets;
+
+            if (isPawn)
+            {
+                // nothing to take but the lone king, so a pawn only pushes
+                targets = GetSquareBB(from + 8) & ~occupied;
+
+                if (targets && from < 16)
+                    targets |= GetSquareBB(from + 16) & ~occupied;
+            }
+            else
+            {
+                targets = GetAttacks(material.m_Types[i], from, occupied) & ~occupied;
+
+                if (i == 0)
+                    targets &= ~GetKingAttacks(position.m_Squares[1]);
+            }
+
+            while (targets)
+            {
+                squares[i] = PopLSB(targets);
+
+                if (isPawn && squares[i] >= 56)
+                {
+                    result.m_Promoted = i;
+
+                    for (const auto promotion : s_PromotionTypes)
+                    {
+                        result.m_Promotion = promotion;
+
+                        visit(result);
+                    }
+
+                    result.m_Promoted  = -1;
+                    result.m_Promotion = CChessPiece::Type::None;
+                }
+                else
+                    visit(result);
+            }
+
+            squares[i] = from;
+        }
+
+        return;
+    }
+
+    const int from = position.m_Squares[1];
+
+    for (Bitboard targets = GetKingAttacks(from) & ~GetKingAttacks(position.m_Squares[0]); targets; )
+    {
+        const int to = PopLSB(targets);
+
+        int captured = -1;
+
+        for (int i = 2; i < material.m_NumPieces; ++i)
+            if (position.m_Squares[i] == to)
+                captured = i;
+
+        squares[1] = to;
+
+        // the attacks see through the square the king leaves, it can't step back along the line of a slider
+        if (IsAttackedByStrong(material, result.m_Position, to, (occupied & ~GetSquareBB(from)) | GetSquareBB(to), captured))
+            continue;
+
+        result.m_Captured = captured;
+
+        visit(result);
+    }
+}
+
+// calls visit with every legal position the side not to move can have come from by a move that is neither a capture
+// nor a promotion
+template <typename Visit>
+void ForEachPredecessor(const CTablebaseMaterial & material, const CPosition & position, Visit visit)
+{
+    const Bitboard occupied = GetOccupied(material, position);
+
+    CPosition predecessor = position;
+    predecessor.m_IsStrongToMove = !position.m_IsStrongToMove;
+
+    for (int i = 0; i < material.m_NumPieces; ++i)
+    {
+        // only the side that has just moved
+        if ((i == 1) != position.m_IsStrongToMove)
+            continue;
+
+        const int to = position.m_Squares[i];
+
+        Bitboard sources;
+
+        if (material.m_Types[i] == CChessPiece::Type::Pawn)
+        {
+            sources = GetSquareBB(to - 8) & ~occupied;
+
+            if (sources && to >= 24 && to < 32)
+                sources |= GetSquareBB(to - 16) & ~occupied;
+
+            sources &= ~Bitboard(0xFF);
+        }
+        else
+            sources = GetAttacks(material.m_Types[i], to, occupied) & ~occupied;
+
+        while (sources)
+        {
+            predecessor.m_Squares[i] = PopLSB(sources);
+
+            if (IsLegalPosition(material, predecessor))
+                visit(predecessor);
+        }
+
+        predecessor.m_Squares[i] = to;
+    }
+}
+
+// runs body(begin, end) over the chunks of [0, size), on numThreads threads
+template <typename Body>
+void ParallelFor(const std::uint64_t size, const int numThreads, Body body)
+{
+    std::atomic<std::uint64_t> nextChunk(0);
+
+    auto Run = [&]()
+    {
+        for (std::uint64_t begin = nextChunk.fetch_add(s_ChunkSize); begin < size; begin = nextChunk.fetch_add(s_ChunkSize))
+            body(begin, std::min(begin + s_ChunkSize, size));
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int i = 1; i < numThreads; ++i)
+        threads.emplace_back(Run);
+
+    Run();
+
+    for (auto & thread : threads)
+        thread.join();
+}
+
+} // namespace
+
+// CTablebaseTable
+
+class CTablebaseTable
+{
+public:
+    bool Open(const std::string & fileName, const CTablebaseMaterial & material)
+    {
+        if (!m_File.Open(fileName.c_str()))
+            return false;
+
+        const auto * data = reinterpret_cast<const std::uint8_t *>(m_File.GetData());
+
+        const bool isValid = m_File.GetSize() >= s_HeaderSize && std::memcmp(data, s_FileMagic, sizeof(s_FileMagic)) == 0;
+
+        m_Bits = isValid ? static_cast<int>(ReadLittleEndian(data + 8, 4)) : 0;
+
+        const std::uint64_t numValues = isValid ? ReadLittleEndian(data + 16, 8) : 0;
+
+        if (m_Bits < 1 || m_Bits > 16 || numValues != material.m_Size || m_File.GetSize() < s_HeaderSize + (numValues * m_Bits + 7) / 8 + s_FilePadding)
+        {
+            m_File.Close();
+
+            return false;
+        }
+
+        m_Material = material;
+
+        return true;
+    }
+
+    const CTablebaseMaterial & GetMaterial() const
+    {
+        return m_Material;
+    }
+
+    // the value at the index, 0 for an invalid index as well
+    int GetValue(const std::uint64_t index) const
+    {
+        const std::uint64_t bit = index * m_Bits;
+
+        const auto * bytes = reinterpret_cast<const std::uint8_t *>(m_File.GetData()) + s_HeaderSize + bit / 8;
+
+        const std::uint32_t window = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16);
+
+        const int code = static_cast<int>((window >> (bit % 8)) & ((1u << m_Bits) - 1));
+
+        // mated in 0 plies is 1, so the losses are the odd codes
+        return (code & 1) ? -code : code;
+    }
+
+private:
+    CTablebaseMaterial  m_Material;
+    CMappedFile         m_File;
+    int                 m_Bits = 0;
+};
+
+// CTablebases
+
+CTablebases::CTablebases() = default;
+
+CTablebases::~CTablebases() = default;
+
+int CTablebases::Load(const char * directory)
+{
+    Close();
+
+    const CChessPiece::Type types[] =
+    {
+        CChessPiece::Type::Queen,
+        CChessPiece::Type::Rook,
+        CChessPiece::Type::Bishop,
+        CChessPiece::Type::Knight,
+        CChessPiece::Type::Pawn
+    };
+
+    const int numTypes = static_cast<int>(sizeof(types) / sizeof(types[0]));
+
+    auto TryLoad = [&](const std::initializer_list<CChessPiece::Type> & pieces)
+    {
+        CTablebaseMaterial material;
+
+        if (SetMaterial(material, pieces.begin(), static_cast<int>(pieces.size())))
+            LoadTable(directory, material);
+    };
+
+    // every material of one to three pieces besides the kings
+    for (int a = 0; a < numTypes; ++a)
+    {
+        TryLoad({ types[a] });
+
+        for (int b = a; b < numTypes; ++b)
+        {
+            TryLoad({ types[a], types[b] });
+
+            for (int c = b; c < numTypes; ++c)
+                TryLoad({ types[a], types[b], types[c] });
+        }
+    }
+
+    return GetNumTables();
+}
+
+void CTablebases::Close()
+{
+    m_TablesBySignature.clear();
+    m_Tables.clear();
+
+    m_MaxPieces = 2;
+}
+
+int CTablebases::GetNumTables() const
+{
+    return static_cast<int>(m_Tables.size());
+}
+
+int CTablebases::GetMaxPieces() const
+{
+    return m_MaxPieces;
+}
+
+bool CTablebases::Probe(const CChessGame & game, Outcome & outcome, int & plies) const
+{
+    const auto & board = game.GetBoard();
+
+    const int numPieces = PopCount(board.GetOccupiedBB());
+
+    if (numPieces > m_MaxPieces)
+        return false;
+
+    for (const auto color : { CChessPiece::Color::White, CChessPiece::Color::Black })
+        if (game.HasCastlingRight(color, true) || game.HasCastlingRight(color, false))
+            return false;
+
+    const bool isWhiteStrong = PopCount(board.GetColorBB(CChessPiece::Color::White)) > 1;
+
+    const auto strongColor = isWhiteStrong ? CChessPiece::Color::White : CChessPiece::Color::Black;
+    const auto weakColor   = isWhiteStrong ? CChessPiece::Color::Black : CChessPiece::Color::White;
+
+    if (PopCount(board.GetColorBB(weakColor)) > 1)
+        return false;
+
+    // with black as the strong side the ranks are mirrored, the tables have the strong side white
+    const int flip = isWhiteStrong ? 0 : 56;
+
+    CChessPiece::Type types[s_MaxPieces] = { CChessPiece::Type::King, CChessPiece::Type::King };
+
+    int squares[s_MaxPieces] =
+    {
+        GetLSB(board.GetPiecesBB(CChessPiece::Type::King, strongColor)) ^ flip,
+        GetLSB(board.GetPiecesBB(CChessPiece::Type::King, weakColor)) ^ flip
+    };
+
+    int numTablePieces = 2;
+
+    for (Bitboard bb = board.GetColorBB(strongColor) & ~board.GetTypeBB(CChessPiece::Type::King); bb; ++numTablePieces)
+    {
+        const int index = PopLSB(bb);
+
+        types[numTablePieces]   = board.GetPieceAtIndex(index).GetType();
+        squares[numTablePieces] = index ^ flip;
+    }
+
+    int value = 0;
+
+    if (numTablePieces > 2 && !ProbePieces(types, squares, numTablePieces, game.GetCurrentMoveColor() == strongColor, value))
+        return false;
+
+    if (value > 0)
+        outcome = Outcome::Win;
+    else
+    if (value < 0)
+        outcome = Outcome::Loss;
+    else
+        outcome = Outcome::Draw;
+
+    plies = (value == 0) ? 0 : GetPlies(value);
+
+    return true;
+}
+
+bool CTablebases::Generate(const char * directory, const char * signature, const TablebaseCallback & callback, int numThreads /*= 0*/)
+{
+    CTablebaseMaterial material;
+
+    if (!ParseSignature(signature, material))
+        return false;
+
+    if (numThreads <= 0)
+        numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+    // the bare kings need no table
+    return material.m_NumPieces == 2 || GenerateTable(directory, material, callback, numThreads);
+}
+
+bool CTablebases::ProbePieces(const CChessPiece::Type * types, const int * squares, const int numPieces, const bool isStrongToMove, int & value) const
+{
+    assert(numPieces > 2 && numPieces <= s_MaxPieces);
+
+    CChessPiece::Type sortedTypes[s_MaxPieces];
+
+    CPosition position;
+    position.m_IsStrongToMove = isStrongToMove;
+
+    // the pieces after the kings in the order of the material
+    for (int i = 0; i < numPieces; ++i)
+    {
+        int j = i;
+
+        for (; j > 2 && sortedTypes[j - 1] > types[i]; --j)
+        {
+            sortedTypes[j]        = sortedTypes[j - 1];
+            position.m_Squares[j] = position.m_Squares[j - 1];
+        }
+
+        sortedTypes[j]        = types[i];
+        position.m_Squares[j] = squares[i];
+    }
+
+    char signature[s_MaxPieces + 1] = {};
+
+    for (int i = 1; i < numPieces; ++i)
+        signature[i - 1] = s_PieceLetters[static_cast<int>(sortedTypes[i])];
+
+    signature[numPieces - 1] = 'K';
+
+    const auto it = m_TablesBySignature.find(signature);
+    if (it == m_TablesBySignature.end())
+        return false;
+
+    const auto * table = it->second;
+
+    value = table->GetValue(GetIndex(table->GetMaterial(), position));
+
+    return true;
+}
+
+bool CTablebases::GenerateTable(const std::string & directory, const CTablebaseMaterial & material, const TablebaseCallback & callback, const int numThreads)
+{
+    if (m_TablesBySignature.count(material.m_Signature) > 0 || LoadTable(directory, material))
+        return true;
+
+    // first the materials a capture or a promotion leads to
+    for (int i = 2; i < material.m_NumPieces; ++i)
+    {
+        CChessPiece::Type types[s_MaxPieces];
+
+        int numTypes = 0;
+
+        for (int j = 2; j < material.m_NumPieces; ++j)
+            if (j != i)
+                types[numTypes++] = material.m_Types[j];
+
+        CTablebaseMaterial subMaterial;
+
+        if (numTypes > 0 && SetMaterial(subMaterial, types, numTypes) && !GenerateTable(directory, subMaterial, callback, numThreads))
+            return false;
+
+        if (material.m_Types[i] != CChessPiece::Type::Pawn)
+            continue;
+
+        for (const auto promotion : s_PromotionTypes)
+        {
+            types[numTypes] = promotion;
+
+            if (SetMaterial(subMaterial, types, numTypes + 1) && !GenerateTable(directory, subMaterial, callback, numThreads))
+                return false;
+        }
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const std::uint64_t size = material.m_Size;
+
+    std::unique_ptr<std::atomic<std::int16_t>[]> values(new std::atomic<std::int16_t>[size]);
+
+    // the fastest win by a promotion, the level passes set it when no faster win has turned up
+    std::vector<std::int16_t> promotionWins(material.m_HasPawns ? size : 0, 0);
+
+    std::atomic<int>  maxPlies(0);
+    std::atomic<bool> isProbeFailed(false);
+
+    auto UpdateMaxPlies = [&](const int plies)
+    {
+        for (int current = maxPlies.load(); plies > current && !maxPlies.compare_exchange_weak(current, plies); )
+        {
+        }
+    };
+
+    // the value of a move for the side that makes it, s_Unknown while its position is not solved
+    auto GetMoveValue = [&](const CMoveResult & result)
+    {
+        int value = 0;
+
+        if (!result.IsConversion())
+        {
+            value = values[GetIndex(material, result.m_Position)].load(std::memory_order_relaxed);
+
+            assert(value != s_Invalid);
+
+            if (value == s_Unknown)
+                return s_Unknown;
+        }
+        else
+        {
+            CChessPiece::Type types[s_MaxPieces];
+
+            int squares[s_MaxPieces];
+
+            int numPieces = 0;
+
+            for (int i = 0; i < material.m_NumPieces; ++i)
+                if (i != result.m_Captured)
+                {
+                    types[numPieces]     = (i == result.m_Promoted) ? result.m_Promotion : material.m_Types[i];
+                    squares[numPieces++] = result.m_Position.m_Squares[i];
+                }
+
+            if (numPieces > 2 && !ProbePieces(types, squares, numPieces, result.m_Position.m_IsStrongToMove, value))
+                isProbeFailed = true;
+        }
+
+        return GetParentValue(value);
+    };
+
+    // the value of a position whose moves are all solved, s_Unknown otherwise
+    auto GetSolvedValue = [&](const CPosition & position)
+    {
+        int best = s_Unknown;
+
+        bool isSolved = true;
+
+        ForEachMove(material, position, [&](const CMoveResult & result)
+        {
+            if (!isSolved)
+                return;
+
+            const int value = GetMoveValue(result);
+
+            if (value == s_Unknown)
+                isSolved = false;
+            else
+            if (best == s_Unknown || GetValueRank(value) > GetValueRank(best))
+                best = value;
+        });
+
+        return isSolved ? best : s_Unknown;
+    };
+
+    // the positions without a move within the table are solved at once, mate and stalemate included
+    ParallelFor(size, numThreads, [&](const std::uint64_t begin, const std::uint64_t end)
+    {
+        CPosition position;
+
+        for (std::uint64_t index = begin; index < end; ++index)
+        {
+            DecodeIndex(material, index, position);
+
+            if (GetIndex(material, position) != index || !IsLegalPosition(material, position))
+            {
+                values[index].store(s_Invalid, std::memory_order_relaxed);
+
+                continue;
+            }
+
+            int numMoves       = 0;
+            int numConversions = 0;
+            int bestConversion = 0;
+
+            ForEachMove(material, position, [&](const CMoveResult & result)
+            {
+                ++numMoves;
+
+                if (!result.IsConversion())
+                    return;
+
+                const int value = GetMoveValue(result);
+
+                if (numConversions++ == 0 || GetValueRank(value) > GetValueRank(bestConversion))
+                    bestConversion = value;
+            });
+
+            int value = s_Unknown;
+
+            if (numMoves == 0)
+                value = (!position.m_IsStrongToMove && IsAttackedByStrong(material, position, position.m_Squares[1], GetOccupied(material, position))) ? GetLossValue(0) : 0;
+            else
+            if (numConversions == numMoves)
+                value = bestConversion;
+            else
+            if (bestConversion > 0 && material.m_HasPawns)
+            {
+                promotionWins[index] = static_cast<std::int16_t>(bestConversion);
+
+                UpdateMaxPlies(GetPlies(bestConversion));
+            }
+
+            if (value != s_Unknown && value != 0)
+                UpdateMaxPlies(GetPlies(value));
+
+            values[index].store(static_cast<std::int16_t>(value), std::memory_order_relaxed);
+        }
+    });
+
+    if (isProbeFailed)
+        return false;
+
+    // level by level: the wins in n plies come from the losses in n - 1, the losses in n from the wins in n - 1
+    for (int level = 1; level <= maxPlies.load() + 1; ++level)
+    {
+        const std::int16_t winValue          = static_cast<std::int16_t>(GetWinValue(level));
+        const std::int16_t previousLossValue = static_cast<std::int16_t>(GetLossValue(level - 1));
+        const std::int16_t previousWinValue  = static_cast<std::int16_t>(GetWinValue(level - 1));
+
+        ParallelFor(size, numThreads, [&](const std::uint64_t begin, const std::uint64_t end)
+        {
+            CPosition position;
+
+            for (std::uint64_t index = begin; index < end; ++index)
+            {
+                std::int16_t value = values[index].load(std::memory_order_relaxed);
+
+                if (value == s_Unknown && !promotionWins.empty() && promotionWins[index] == winValue)
+                    values[index].compare_exchange_strong(value, winValue, std::memory_order_relaxed);
+
+                if (value != previousLossValue)
+                    continue;
+
+                DecodeIndex(material, index, position);
+
+                ForEachPredecessor(material, position, [&](const CPosition & predecessor)
+                {
+                    std::int16_t expected = s_Unknown;
+
+                    if (values[GetIndex(material, predecessor)].compare_exchange_strong(expected, winValue, std::memory_order_relaxed))
+                        UpdateMaxPlies(level);
+                });
+            }
+        });
+
+        // a predecessor of a win is solved once all its moves are, a loss unless it has found a draw or a win
+        ParallelFor(size, numThreads, [&](const std::uint64_t begin, const std::uint64_t end)
+        {
+            CPosition position;
+
+            for (std::uint64_t index = begin; index < end; ++index)
+            {
+                if (values[index].load(std::memory_order_relaxed) != previousWinValue)
+                    continue;
+
+                DecodeIndex(material, index, position);
+
+                ForEachPredecessor(material, position, [&](const CPosition & predecessor)
+                {
+                    auto & predecessorValue = values[GetIndex(material, predecessor)];
+
+                    if (predecessorValue.load(std::memory_order_relaxed) != s_Unknown)
+                        return;
+
+                    const int solved = GetSolvedValue(predecessor);
+
+                    std::int16_t expected = s_Unknown;
+
+                    if (solved != s_Unknown && predecessorValue.compare_exchange_strong(expected, static_cast<std::int16_t>(solved), std::memory_order_relaxed) && solved != 0)
+                        UpdateMaxPlies(GetPlies(solved));
+                });
+            }
+        });
+    }
+
+    if (isProbeFailed)
+        return false;
+
+    // what is still unknown can't be forced either way
+    CTablebaseStats stats;
+    stats.m_Signature = material.m_Signature;
+
+    int maxCode = 1;
+
+    for (std::uint64_t index = 0; index < size; ++index)
+    {
+        const int value = values[index].load(std::memory_order_relaxed);
+
+        if (value == s_Invalid)
+            continue;
+
+        ++stats.m_NumPositions;
+
+        if (value > 0)
+            ++stats.m_NumWins;
+        else
+        if (value < 0 && value != s_Unknown)
+            ++stats.m_NumLosses;
+        else
+            ++stats.m_NumDraws;
+
+        if (value != s_Unknown && value != 0)
+        {
+            stats.m_LongestMate = std::max(stats.m_LongestMate, GetPlies(value));
+
+            maxCode = std::max(maxCode, std::abs(value));
+        }
+    }
+
+    int bits = 1;
+
+    while ((1 << bits) <= maxCode)
+        ++bits;
+
+    std::vector<std::uint8_t> data(s_HeaderSize + (size * bits + 7) / 8 + s_FilePadding, 0);
+
+    std::memcpy(data.data(), s_FileMagic, sizeof(s_FileMagic));
+
+    WriteLittleEndian(&data[8],  4, bits);
+    WriteLittleEndian(&data[16], 8, size);
+
+    for (std::uint64_t index = 0; index < size; ++index)
+    {
+        const int value = values[index].load(std::memory_order_relaxed);
+
+        if (value == s_Invalid || value == s_Unknown || value == 0)
+            continue;
+
+        const std::uint64_t bit = index * bits;
+
+        const std::uint32_t shifted = static_cast<std::uint32_t>(std::abs(value)) << (bit % 8);
+
+        auto * bytes = &data[s_HeaderSize + bit / 8];
+
+        bytes[0] |= static_cast<std::uint8_t>(shifted);
+        bytes[1] |= static_cast<std::uint8_t>(shifted >> 8);
+        bytes[2] |= static_cast<std::uint8_t>(shifted >> 16);
+    }
+
+    values.reset();
+
+    {
+        std::ofstream file(directory + "/" + material.m_Signature + s_FileExtension, std::ios::binary);
+
+        file.write(reinterpret_cast<const char *>(data.data()), data.size());
+
+        if (!file)
+            return false;
+    }
+
+    stats.m_Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    if (!LoadTable(directory, material))
+        return false;
+
+    if (callback)
+        callback(stats);
+
+    return true;
+}
+
+bool CTablebases::LoadTable(const std::string & directory, const CTablebaseMaterial & material)
+{
+    std::unique_ptr<CTablebaseTable> table(new CTablebaseTable());
+
+    if (!table->Open(directory + "/" + material.m_Signature + s_FileExtension, material))
+        return false;
+
+    m_TablesBySignature[material.m_Signature] = table.get();
+
+    m_Tables.push_back(std::move(table));
+
+    m_MaxPieces = std::max(m_MaxPieces, material.m_NumPieces);
+
+    return true;
+}
+
+} // namespace ChessPro
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ChessGame.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ChessProj
+{
+
+class CTablebaseTable;
+struct CTablebaseMaterial;
+
+struct CTablebaseStats
+{
+    std::string     m_Signature;            // e.g. "KBNK"
+    std::uint64_t   m_NumPositions = 0;     // the legal ones of the index, with either side to move
+    std::uint64_t   m_NumWins      = 0;     // for the side to move
+    std::uint64_t   m_NumDraws     = 0;
+    std::uint64_t   m_NumLosses    = 0;
+    int             m_LongestMate  = 0;     // in plies
+    double          m_Seconds      = 0.0;
+};
+
+// called after every generated table
+using TablebaseCallback = std::function<void(const CTablebaseStats & stats)>;
+
+// endgame tables of a king and up to three pieces against a lone king: KQK, KRK, KPK, KBNK, KRBK and so on, with the
+// distance to mate in plies of every position with the best play of both sides. The tables are generated here by
+// retrograde analysis and kept in memory-mapped files, bit-packed at the width their longest mate needs.
+// Read-only once loaded, so the search threads can share them
+class CTablebases
+{
+public:
+    static const int s_MaxPieces = 5;   // with the kings
+
+    enum class Outcome
+    {
+        Win,    // for the side to move
+        Draw,
+        Loss
+    };
+
+    CTablebases();
+    ~CTablebases();
+
+    CTablebases(const CTablebases &) = delete;
+    CTablebases & operator=(const CTablebases &) = delete;
+
+    // maps the tables found in the directory, returns their number
+    int Load(const char * directory);
+
+    void Close();
+
+    int GetNumTables() const;
+
+    // of the largest loaded table, with the kings. 2 with no tables, as the bare kings are always known
+    int GetMaxPieces() const;
+
+    // false if no table covers the position: more pieces, pieces on both sides or castling rights. Otherwise
+    // plies is the distance to mate (0 for a draw, or for the side to move being mated). The fifty-move rule is ignored
+    bool Probe(const CChessGame & game, Outcome & outcome, int & plies) const;
+
+    // generates the table of the material, e.g. "KBNK", with numThreads threads (0 = one per hardware thread), and
+    // before it the tables of the materials it can turn into by a capture or a promotion. The tables already in the
+    // directory are loaded instead. Returns false for an unsupported signature or a file that can't be written
+    bool Generate(const char * directory, const char * signature, const TablebaseCallback & callback, int numThreads = 0);
+
+private:
+    // the value of the position (see ChessTablebase.cpp) from the table of its material. The strong side is white,
+    // the pieces are any order after the two kings. False if the table is not loaded
+    bool ProbePieces(const CChessPiece::Type * types, const int * squares, const int numPieces, const bool isStrongToMove, int & value) const;
+
+    bool GenerateTable(const std::string & directory, const CTablebaseMaterial & material, const TablebaseCallback & callback, const int numThreads);
+
+    bool LoadTable(const std::string & directory, const CTablebaseMaterial & material);
+
+    std::vector<std::unique_ptr<CTablebaseTable>>           m_Tables;
+    std::unordered_map<std::string, const CTablebaseTable *> m_TablesBySignature;
+    int                                                     m_MaxPieces = 2;
+};
+
+} // namespace ChessProj
\ No newline at end of file
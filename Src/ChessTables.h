@@ -0,0 +1,173 @@
+#pragma once
+
+#include "ChessBitboard.h"
+#include "ChessPiece.h"
+
+#include <cstdint>
+
+namespace ChessProj
+{
+
+// compile-time geometry tables. They are constexpr C++17 inline variables, so every translation unit
+// shares one copy that needs no dynamic initialization
+
+struct COffset
+{
+    int m_Rank;
+    int m_File;
+};
+
+constexpr COffset s_KingOffsets[]       = { {-1, -1}, {-1, 0}, {-1, 1}, {1, -1}, {1, 0}, {1, 1}, {0, -1}, {0, 1} };
+constexpr COffset s_KnightOffsets[]     = { {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1} };
+constexpr COffset s_DiagonalOffsets[]   = { {-1, -1}, {-1, 1}, {1, 1}, {1, -1} };
+constexpr COffset s_OrthogonalOffsets[] = { {-1, 0}, {1, 0}, {0, 1}, {0, -1} };
+
+constexpr bool IsOnBoard(const int rank, const int file)
+{
+    return rank > -1 && rank < 8 && file > -1 && file < 8;
+}
+
+// the tables are split, so that each stays well within the compilers' constexpr evaluation limits
+
+struct CStepTables
+{
+    constexpr CStepTables()
+        : m_Knight{}
+        , m_King{}
+        , m_Pawn{}
+    {
+        for (int index = 0; index < 64; ++index)
+        {
+            const int rank = index / 8;
+            const int file = index % 8;
+
+            for (const auto & offset : s_KnightOffsets)
+                if (IsOnBoard(rank + offset.m_Rank, file + offset.m_File))
+                    m_Knight[index] |= GetSquareBB((rank + offset.m_Rank) * 8 + file + offset.m_File);
+
+            for (const auto & offset : s_KingOffsets)
+                if (IsOnBoard(rank + offset.m_Rank, file + offset.m_File))
+                    m_King[index] |= GetSquareBB((rank + offset.m_Rank) * 8 + file + offset.m_File);
+
+            // White pawns capture towards rank 8, Black ones towards rank 1
+            for (const auto & offset : s_DiagonalOffsets)
+                if (IsOnBoard(rank + offset.m_Rank, file + offset.m_File))
+                    m_Pawn[offset.m_Rank > 0 ? 0 : 1][index] |= GetSquareBB((rank + offset.m_Rank) * 8 + file + offset.m_File);
+        }
+    }
+
+    Bitboard    m_Knight[64];
+    Bitboard    m_King[64];
+    Bitboard    m_Pawn[2][64]; // indexed by CChessPiece::Color
+};
+
+struct CLineTables
+{
+    constexpr CLineTables()
+        : m_Between{}
+        , m_Line{}
+    {
+        for (int index = 0; index < 64; ++index)
+        {
+            AddLines(index, s_DiagonalOffsets);
+            AddLines(index, s_OrthogonalOffsets);
+        }
+    }
+
+    // the offsets must contain the opposite of each direction
+    constexpr void AddLines(const int index, const COffset (& offsets)[4])
+    {
+        const int rank = index / 8;
+        const int file = index % 8;
+
+        for (const auto & offset : offsets)
+        {
+            const COffset opposite = { -offset.m_Rank, -offset.m_File };
+
+            Bitboard line = GetSquareBB(index);
+
+            for (int r = rank + offset.m_Rank, c = file + offset.m_File; IsOnBoard(r, c); r += offset.m_Rank, c += offset.m_File)
+                line |= GetSquareBB(r * 8 + c);
+
+            for (int r = rank + opposite.m_Rank, c = file + opposite.m_File; IsOnBoard(r, c); r += opposite.m_Rank, c += opposite.m_File)
+                line |= GetSquareBB(r * 8 + c);
+
+            Bitboard between = 0;
+
+            for (int r = rank + offset.m_Rank, c = file + offset.m_File; IsOnBoard(r, c); r += offset.m_Rank, c += offset.m_File)
+            {
+                m_Between[index][r * 8 + c] = between;
+                m_Line[index][r * 8 + c]    = line;
+
+                between |= GetSquareBB(r * 8 + c);
+            }
+        }
+    }
+
+    Bitboard    m_Between[64][64];
+    Bitboard    m_Line[64][64];
+};
+
+struct CDistanceTable
+{
+    constexpr CDistanceTable()
+        : m_Distance{}
+    {
+        for (int index1 = 0; index1 < 64; ++index1)
+            for (int index2 = 0; index2 < 64; ++index2)
+            {
+                const int ranks = (index1 / 8 > index2 / 8) ? index1 / 8 - index2 / 8 : index2 / 8 - index1 / 8;
+                const int files = (index1 % 8 > index2 % 8) ? index1 % 8 - index2 % 8 : index2 % 8 - index1 % 8;
+
+                m_Distance[index1][index2] = static_cast<std::uint8_t>(ranks > files ? ranks : files);
+            }
+    }
+
+    std::uint8_t    m_Distance[64][64];
+};
+
+inline constexpr CStepTables    s_StepTables;
+inline constexpr CLineTables    s_LineTables;
+inline constexpr CDistanceTable s_DistanceTable;
+
+constexpr Bitboard GetKnightAttacks(const int index)
+{
+    return s_StepTables.m_Knight[index];
+}
+
+constexpr Bitboard GetKingAttacks(const int index)
+{
+    return s_StepTables.m_King[index];
+}
+
+// squares attacked by a pawn of the color standing on the index
+constexpr Bitboard GetPawnAttacks(const int index, const CChessPiece::Color color)
+{
+    return s_StepTables.m_Pawn[static_cast<int>(color)][index];
+}
+
+// the squares strictly between two squares on a common line, 0 if they aren't on one
+constexpr Bitboard GetBetweenBB(const int index1, const int index2)
+{
+    return s_LineTables.m_Between[index1][index2];
+}
+
+// the whole board-wide line through two squares (both included), 0 if they aren't on one
+constexpr Bitboard GetLineBB(const int index1, const int index2)
+{
+    return s_LineTables.m_Line[index1][index2];
+}
+
+// Chebyshev distance: the number of king steps between two squares
+constexpr int GetDistance(const int index1, const int index2)
+{
+    return s_DistanceTable.m_Distance[index1][index2];
+}
+
+static_assert(GetKnightAttacks(0) == (GetSquareBB(10) | GetSquareBB(17)), "knight attacks");
+static_assert(GetBetweenBB(0, 63) == 0x0040201008040200ull, "between squares");
+static_assert(GetLineBB(0, 7) == 0xFFull && GetLineBB(0, 10) == 0, "lines");
+static_assert(GetPawnAttacks(12, CChessPiece::Color::White) == (GetSquareBB(19) | GetSquareBB(21)), "pawn attacks");
+static_assert(GetDistance(0, 63) == 7, "distance");
+
+} // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "ChessTransTable.h"
+
+#include <cassert>
+
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+namespace ChessProj
+{
+
+namespace
+{
+
+// data layout: move (16 bits), score (16), depth (8), bound (8), generation (8)
+
+std::uint64_t EncodeMove(const CChessMove & mv)
+{
+    return mv.GetData(); // 0 for no move
+}
+
+CChessMove DecodeMove(const std::uint64_t data)
+{
+    return CChessMove::FromData(static_cast<std::uint16_t>(data & 0xFFFF));
+}
+
+std::uint64_t EncodeData(const CChessMove & mv, const int score, const int depth, const CTransTable::Bound bound, const std::uint8_t generation)
+{
+    assert(score >= INT16_MIN && score <= INT16_MAX);
+    assert(depth >= INT8_MIN && depth <= INT8_MAX);
+
+    return EncodeMove(mv) |
+           static_cast<std::uint64_t>(static_cast<std::uint16_t>(score)) << 16 |
+           static_cast<std::uint64_t>(static_cast<std::uint8_t>(depth)) << 32 |
+           static_cast<std::uint64_t>(bound) << 40 |
+           static_cast<std::uint64_t>(generation) << 48;
+}
+
+int GetDataDepth(const std::uint64_t data)
+{
+    return static_cast<std::int8_t>((data >> 32) & 0xFF);
+}
+
+CTransTable::Bound GetDataBound(const std::uint64_t data)
+{
+    return static_cast<CTransTable::Bound>((data >> 40) & 0xFF);
+}
+
+std::uint8_t GetDataGeneration(const std::uint64_t data)
+{
+    return static_cast<std::uint8_t>(data >> 48);
+}
+
+} // namespace
+
+CTransTable::CTransTable(const std::size_t sizeMB /*= 16*/)
+    : m_Generation(0)
+{
+    Resize(sizeMB);
+}
+
+void CTransTable::Resize(const std::size_t sizeMB)
+{
+    const std::size_t maxBuckets = (sizeMB > 0 ? sizeMB : 1) * 1024 * 1024 / sizeof(CBucket);
+
+    std::size_t numBuckets = 1;
+    while (numBuckets * 2 <= maxBuckets)
+        numBuckets *= 2;
+
+    if (numBuckets != m_NumBuckets)
+    {
+        m_Buckets.reset(new CBucket[numBuckets]);
+        m_NumBuckets = numBuckets;
+    }
+
+    Clear();
+}
+
+void CTransTable::Clear()
+{
+    for (std::size_t i = 0; i < m_NumBuckets; ++i)
+        for (auto & slot : m_Buckets[i].m_Slots)
+        {
+            slot.m_Key.store(0, std::memory_order_relaxed);
+            slot.m_Data.store(0, std::memory_order_relaxed);
+        }
+
+    m_Generation.store(0, std::memory_order_relaxed);
+}
+
+void CTransTable::NewSearch()
+{
+    m_Generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool CTransTable::Probe(const std::uint64_t hash, CEntry & entry) const
+{
+    for (const auto & slot : GetBucket(hash).m_Slots)
+    {
+        const auto data = slot.m_Data.load(std::memory_order_relaxed);
+
+        if ((slot.m_Key.load(std::memory_order_relaxed) ^ data) != hash || GetDataBound(data) == Bound::None)
+            continue;
+
+        entry.m_Move  = DecodeMove(data);
+        entry.m_Score = static_cast<std::int16_t>((data >> 16) & 0xFFFF);
+        entry.m_Depth = GetDataDepth(data);
+        entry.m_Bound = GetDataBound(data);
+
+        return true;
+    }
+
+    return false;
+}
+
+void CTransTable::Store(const std::uint64_t hash, const CChessMove & mv, const int score, const int depth, const Bound bound)
+{
+    auto & bucket = m_Buckets[hash & (m_NumBuckets - 1)];
+
+    const std::uint8_t generation = m_Generation.load(std::memory_order_relaxed);
+
+    CSlot * replace = nullptr;
+
+    int replaceValue = INT32_MAX;
+
+    for (auto & slot : bucket.m_Slots)
+    {
+        const auto data = slot.m_Data.load(std::memory_order_relaxed);
+
+        if ((slot.m_Key.load(std::memory_order_relaxed) ^ data) == hash)
+        {
+            // a shallower result of the current search doesn't overwrite a deeper one, unless it is exact
+            if (bound != Bound::Exact && GetDataGeneration(data) == generation && depth + 2 < GetDataDepth(data))
+                return;
+
+            // keep the known best move if the new result has none
+            const CChessMove bestMove = mv.IsValid() ? mv : DecodeMove(data);
+
+            const auto newData = EncodeData(bestMove, score, depth, bound, generation);
+
+            slot.m_Key.store(hash ^ newData, std::memory_order_relaxed);
+            slot.m_Data.store(newData, std::memory_order_relaxed);
+
+            return;
+        }
+
+        // replace the empty, then the oldest and the shallowest entry
+        const int age = static_cast<std::uint8_t>(generation - GetDataGeneration(data));
+
+        const int value = (GetDataBound(data) == Bound::None) ? INT32_MIN : GetDataDepth(data) - 8 * age;
+
+        if (value < replaceValue)
+        {
+            replace      = &slot;
+            replaceValue = value;
+        }
+    }
+
+    const auto newData = EncodeData(mv, score, depth, bound, generation);
+
+    replace->m_Key.store(hash ^ newData, std::memory_order_relaxed);
+    replace->m_Data.store(newData, std::memory_order_relaxed);
+}
+
+void CTransTable::Prefetch(const std::uint64_t hash) const
+{
+#ifdef _MSC_VER
+    _mm_prefetch(reinterpret_cast<const char *>(&GetBucket(hash)), _MM_HINT_T0);
+#else
+    __builtin_prefetch(&GetBucket(hash));
+#endif
+}
+
+int CTransTable::GetHashFull() const
+{
+    const std::size_t numSampled = (m_NumBuckets < 250) ? m_NumBuckets : 250;
+
+    int numUsed = 0;
+
+    for (std::size_t i = 0; i < numSampled; ++i)
+        for (const auto & slot : m_Buckets[i].m_Slots)
+        {
+            const auto data = slot.m_Data.load(std::memory_order_relaxed);
+
+            if (GetDataBound(data) != Bound::None && GetDataGeneration(data) == m_Generation.load(std::memory_order_relaxed))
+                ++numUsed;
+        }
+
+    return static_cast<int>(numUsed * 1000 / (numSampled * s_BucketSize));
+}
+
+std::size_t CTransTable::GetSizeMB() const
+{
+    return m_NumBuckets * sizeof(CBucket) / (1024 * 1024);
+}
+
+const CTransTable::CBucket & CTransTable::GetBucket(const std::uint64_t hash) const
+{
+    return m_Buckets[hash & (m_NumBuckets - 1)];
+}
+
+} // namespace ChessProj
\ No newline at end of file
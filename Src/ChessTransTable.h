@@ -0,0 +1,78 @@
+#pragma once
+
+#include "ChessMove.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ChessProj
+{
+
+// fixed-size hash of searched positions, shared by all search threads without locks
+class CTransTable
+{
+public:
+    enum class Bound
+    {
+        None,
+        Upper,  // the score is at most m_Score (fail low)
+        Lower,  // the score is at least m_Score (fail high)
+        Exact
+    };
+
+    struct CEntry
+    {
+        CChessMove  m_Move;
+        int         m_Score = 0;
+        int         m_Depth = 0;
+        Bound       m_Bound = Bound::None;
+    };
+
+    explicit CTransTable(const std::size_t sizeMB = 16);
+
+    // the size is rounded down to a power of two number of buckets, the contents are cleared
+    void Resize(const std::size_t sizeMB);
+
+    void Clear();
+
+    // ages the stored entries, so that the new search prefers to replace them
+    void NewSearch();
+
+    bool Probe(const std::uint64_t hash, CEntry & entry) const;
+
+    void Store(const std::uint64_t hash, const CChessMove & mv, const int score, const int depth, const Bound bound);
+
+    // asks the CPU to start loading the bucket of the hash, so that the probe after move generation doesn't stall
+    void Prefetch(const std::uint64_t hash) const;
+
+    // permille of the sampled entries written by the current search
+    int GetHashFull() const;
+
+    std::size_t GetSizeMB() const;
+
+private:
+    // lockless entry: the key is stored XOR-ed with the data, a torn write from another thread fails the verification
+    struct CSlot
+    {
+        std::atomic<std::uint64_t>  m_Key;
+        std::atomic<std::uint64_t>  m_Data;
+    };
+
+    static const int s_BucketSize = 4;
+
+    // one cache line
+    struct alignas(64) CBucket
+    {
+        CSlot   m_Slots[s_BucketSize];
+    };
+
+    const CBucket & GetBucket(const std::uint64_t hash) const;
+
+    std::unique_ptr<CBucket[]>  m_Buckets;
+    std::size_t                 m_NumBuckets = 0;
+    std::atomic<std::uint8_t>   m_Generation;           // atomic, as NewSearch may run while helper threads store
+};
+
+} // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "ChessZobrist.h"
+
+namespace ChessProj
+{
+
+namespace
+{
+
+// splitmix64, evaluated at compile time so the keys are fixed and need no initialization
+constexpr std::uint64_t GetRandom(std::uint64_t & state)
+{
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+    return z ^ (z >> 31);
+}
+
+struct CZobristKeys
+{
+    constexpr CZobristKeys()
+        : m_Pieces{}
+        , m_Side(0)
+        , m_Castling{}
+        , m_EnPassant{}
+    {
+        std::uint64_t state = 0x43686573734B6579ull;
+
+        for (int color = 0; color < 2; ++color)
+            for (int type = 0; type < 7; ++type)
+                for (int index = 0; index < 64; ++index)
+                    m_Pieces[color][type][index] = (type == 0) ? 0 : GetRandom(state); // Type::None hashes to nothing
+
+        m_Side = GetRandom(state);
+
+        for (int rights = 0; rights < 16; ++rights)
+            m_Castling[rights] = (rights == 0) ? 0 : GetRandom(state);
+
+        for (int file = 0; file < 8; ++file)
+            m_EnPassant[file] = GetRandom(state);
+    }
+
+    std::uint64_t   m_Pieces[2][7][64]; // [color][type][index]
+    std::uint64_t   m_Side;             // black to move
+    std::uint64_t   m_Castling[16];     // indexed by the castling rights bitmask
+    std::uint64_t   m_EnPassant[8];     // indexed by the column of the en passant square
+};
+
+constexpr CZobristKeys s_Keys;
+
+} // namespace
+
+std::uint64_t GetZobristPieceKey(const CChessPiece & piece, const int index)
+{
+    return s_Keys.m_Pieces[static_cast<int>(piece.GetColor())][static_cast<int>(piece.GetType())][index];
+}
+
+std::uint64_t GetZobristSideKey()
+{
+    return s_Keys.m_Side;
+}
+
+std::uint64_t GetZobristCastlingKey(const std::uint8_t castlingRights)
+{
+    return s_Keys.m_Castling[castlingRights & 15];
+}
+
+std::uint64_t GetZobristEnPassantKey(const int file)
+{
+    return s_Keys.m_EnPassant[file];
+}
+
+} // namespace ChessProj
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "ChessPiece.h"
+
+#include <cstdint>
+
+namespace ChessProj
+{
+
+// random keys for the incremental 64-bit position hash
+
+std::uint64_t GetZobristPieceKey(const CChessPiece & piece, const int index);
+
+std::uint64_t GetZobristSideKey();
+
+std::uint64_t GetZobristCastlingKey(const std::uint8_t castlingRights);
+
+std::uint64_t GetZobristEnPassantKey(const int file);
+
+} // namespace ChessProj
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "MainToolBar.h"
 #include "ChessBoardGraphicsView.h"
 
+#include <QStatusBar>
+
 namespace ChessProj
 {
 
@@ -24,6 +26,8 @@ CMainWindow::CMainWindow(QWidget * pParent)
 
     setCentralWidget(m_View);
 
+    connect(m_View, SIGNAL(AnalysisUpdated(const QString &)), statusBar(), SLOT(showMessage(const QString &)));
+
     CActionManager & actMgr = CActionManager::Instance();
 
     connect(actMgr.GetAction(CActionManager::CommonAction::NewGameAsWhite),   SIGNAL(triggered()), this, SLOT(StartNewGameAsWhite()));
@@ -0,0 +1,156 @@
+#include "ChessBook.h"
+#include "ChessGame.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ChessProj
+{
+
+namespace
+{
+
+int RunBuild(const char * pgnFileName, const char * bookFileName, const char * keysFileName,
+             const CBookBuildOptions & options, const int numThreads)
+{
+    CPolyglotKeys keys;
+
+    if (keysFileName && !keys.Load(keysFileName))
+    {
+        std::printf("can't read the key table %s\n", keysFileName);
+
+        return 1;
+    }
+
+    CBookBuildStats stats;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!BuildPolyglotBook(pgnFileName, bookFileName, keys, options, stats, numThreads))
+    {
+        std::printf("can't build %s from %s\n", bookFileName, pgnFileName);
+
+        return 1;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("games %llu, invalid %llu, positions %llu, entries %llu, time %.3f s\n",
+                static_cast<unsigned long long>(stats.m_PGNStats.m_NumGames), static_cast<unsigned long long>(stats.m_PGNStats.m_NumInvalidGames),
+                static_cast<unsigned long long>(stats.m_NumPositions), static_cast<unsigned long long>(stats.m_NumEntries), seconds);
+
+    return 0;
+}
+
+int RunProbe(const char * bookFileName, const char * keysFileName, const std::string & fen)
+{
+    CPolyglotBook book;
+
+    if (!book.Open(bookFileName, keysFileName))
+    {
+        std::printf("can't open %s\n", bookFileName);
+
+        return 1;
+    }
+
+    CChessGame game;
+
+    if (!game.SetFEN(fen.c_str()))
+    {
+        std::printf("invalid FEN: %s\n", fen.c_str());
+
+        return 1;
+    }
+
+    std::vector<CBookMove> moves;
+    book.GetMoves(game, moves);
+
+    if (moves.empty())
+        std::printf("not in the book\n");
+
+    int totalWeight = 0;
+
+    for (const auto & bookMove : moves)
+        totalWeight += bookMove.m_Weight;
+
+    for (const auto & bookMove : moves)
+        std::printf("%-8s weight %5d  %5.1f%%\n", game.GetMoveSAN(bookMove.m_Move).c_str(), bookMove.m_Weight,
+                    100.0 * bookMove.m_Weight / totalWeight);
+
+    return 0;
+}
+
+void PrintUsage()
+{
+    std::printf("usage:\n"
+                "  MakeBook <pgn> <book> [options]  build a Polyglot book from the games with a result\n"
+                "    -maxply <n>     plies of a game to enter (40 by default)\n"
+                "    -mingames <n>   games a move has to be played in (1 by default)\n"
+                "    -threads <n>    one per hardware thread by default\n"
+                "  MakeBook -probe <book> [fen]     list the book moves of the position (the start position by default)\n"
+                "  both take -keys <file>: a random table of 781 numbers to use instead of the standard Polyglot one\n");
+}
+
+} // namespace
+
+} // namespace ChessProj
+
+int main(int argc, char * argv[])
+{
+    using namespace ChessProj;
+
+    std::vector<const char *> args;
+
+    const char * keysFileName = nullptr;
+
+    CBookBuildOptions options;
+
+    int numThreads = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "-keys") == 0 && hasValue)
+            keysFileName = argv[++i];
+        else
+        if (std::strcmp(argv[i], "-maxply") == 0 && hasValue)
+            options.m_MaxPly = std::atoi(argv[++i]);
+        else
+        if (std::strcmp(argv[i], "-mingames") == 0 && hasValue)
+            options.m_MinGames = std::atoi(argv[++i]);
+        else
+        if (std::strcmp(argv[i], "-threads") == 0 && hasValue)
+            numThreads = std::atoi(argv[++i]);
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (args.size() >= 2 && std::strcmp(args[0], "-probe") == 0)
+    {
+        // the FEN may be passed either quoted or as separate arguments
+        std::string fen;
+
+        for (std::size_t i = 2; i < args.size(); ++i)
+            fen += (fen.empty() ? "" : " ") + std::string(args[i]);
+
+        if (fen.empty())
+            fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+        return RunProbe(args[1], keysFileName, fen);
+    }
+
+    if (args.size() != 2)
+    {
+        PrintUsage();
+
+        return 1;
+    }
+
+    return RunBuild(args[0], args[1], keysFileName, options, numThreads);
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "ChessTablebase.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ChessProj
+{
+
+namespace
+{
+
+int RunGenerate(const char * directory, const std::vector<const char *> & signatures, const int numThreads)
+{
+    CTablebases tablebases;
+
+    auto PrintStats = [](const CTablebaseStats & stats)
+    {
+        std::printf("%-6s positions %llu, wins %llu, draws %llu, losses %llu, longest mate %d plies, time %.3f s\n",
+                    stats.m_Signature.c_str(), static_cast<unsigned long long>(stats.m_NumPositions),
+                    static_cast<unsigned long long>(stats.m_NumWins), static_cast<unsigned long long>(stats.m_NumDraws),
+                    static_cast<unsigned long long>(stats.m_NumLosses), stats.m_LongestMate, stats.m_Seconds);
+    };
+
+    for (const char * signature : signatures)
+        if (!tablebases.Generate(directory, signature, PrintStats, numThreads))
+        {
+            std::printf("can't generate %s in %s\n", signature, directory);
+
+            return 1;
+        }
+
+    return 0;
+}
+
+int RunProbe(const char * directory, const std::string & fen)
+{
+    CTablebases tablebases;
+
+    std::printf("tables %d\n", tablebases.Load(directory));
+
+    CChessGame game;
+
+    if (!game.SetFEN(fen.c_str()))
+    {
+        std::printf("invalid FEN: %s\n", fen.c_str());
+
+        return 1;
+    }
+
+    CTablebases::Outcome outcome;
+
+    int plies = 0;
+
+    if (!tablebases.Probe(game, outcome, plies))
+    {
+        std::printf("not in the tables\n");
+
+        return 1;
+    }
+
+    if (outcome == CTablebases::Outcome::Draw)
+        std::printf("draw\n");
+    else
+        std::printf("%s in %d plies\n", (outcome == CTablebases::Outcome::Win) ? "win" : "loss", plies);
+
+    // the value of every move for the side that makes it
+    CMoveList moves;
+    game.GenerateLegalMoves(moves);
+
+    for (const auto & mv : moves)
+    {
+        const std::string san = game.GetMoveSAN(mv);
+
+        CUndoInfo undo;
+        game.MakeMove(mv, undo);
+
+        CTablebases::Outcome moveOutcome;
+
+        int movePlies = 0;
+
+        if (!tablebases.Probe(game, moveOutcome, movePlies))
+            std::printf("%-8s not in the tables\n", san.c_str());
+        else
+        if (moveOutcome == CTablebases::Outcome::Draw)
+            std::printf("%-8s draw\n", san.c_str());
+        else
+            std::printf("%-8s %s in %d plies\n", san.c_str(), (moveOutcome == CTablebases::Outcome::Loss) ? "win" : "loss", movePlies + 1);
+
+        game.UnmakeMove(mv, undo);
+    }
+
+    return 0;
+}
+
+void PrintUsage()
+{
+    std::printf("usage:\n"
+                "  MakeTablebase <directory> <signature>... [-threads <n>]  generate the tables, e.g. KQK KRK KPK KBNK, and the\n"
+                "                                                           ones they need, into the directory\n"
+                "  MakeTablebase -probe <directory> <fen>                   the value of the position\n");
+}
+
+} // namespace
+
+} // namespace ChessProj
+
+int main(int argc, char * argv[])
+{
+    using namespace ChessProj;
+
+    std::vector<const char *> args;
+
+    int numThreads = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+            numThreads = std::atoi(argv[++i]);
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (args.size() >= 3 && std::strcmp(args[0], "-probe") == 0)
+    {
+        // the FEN may be passed either quoted or as separate arguments
+        std::string fen;
+
+        for (std::size_t i = 2; i < args.size(); ++i)
+            fen += (fen.empty() ? "" : " ") + std::string(args[i]);
+
+        return RunProbe(args[1], fen);
+    }
+
+    if (args.size() < 2)
+    {
+        PrintUsage();
+
+        return 1;
+    }
+
+    return RunGenerate(args[0], std::vector<const char *>(args.begin() + 1, args.end()), numThreads);
+}
\ No newline at end of file
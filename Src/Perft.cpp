@@ -0,0 +1,568 @@
+#include "ChessGame.h"
+#include "ChessPGN.h"
+#include "ChessPackedPosition.h"
+
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ChessProj
+{
+
+namespace
+{
+
+const char * s_StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct CReferencePosition
+{
+    const char *    m_Name;
+    const char *    m_FEN;
+    std::uint64_t   m_Nodes[6]; // expected leaf nodes for depths 1..6, 0 = not listed
+};
+
+// https://www.chessprogramming.org/Perft_Results
+const CReferencePosition s_ReferencePositions[] =
+{
+    { "startpos",   s_StartFEN,
+      { 20, 400, 8902, 197281, 4865609, 119060324 } },
+
+    { "kiwipete",   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      { 48, 2039, 97862, 4085603, 193690690, 0 } },
+
+    { "position3",  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+      { 14, 191, 2812, 43238, 674624, 11030083 } },
+
+    { "position4",  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      { 6, 264, 9467, 422333, 15833292, 0 } },
+
+    { "position4m", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+      { 6, 264, 9467, 422333, 15833292, 0 } },
+
+    { "position5",  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      { 44, 1486, 62379, 2103487, 89941194, 0 } },
+
+    { "position6",  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+      { 46, 2079, 89890, 3894594, 164075551, 0 } }
+};
+
+std::uint64_t Perft(CChessGame & game, const int depth)
+{
+    if (depth == 0)
+        return 1;
+
+    CMoveList moves;
+    game.GenerateLegalMoves(moves);
+
+    if (depth == 1)
+        return moves.GetSize(); // bulk counting at the last ply
+
+    std::uint64_t nodes = 0;
+
+    CUndoInfo undo;
+
+    for (const auto & mv : moves)
+    {
+        game.MakeMove(mv, undo);
+
+        nodes += Perft(game, depth - 1);
+
+        game.UnmakeMove(mv, undo);
+    }
+
+    return nodes;
+}
+
+class CTimer
+{
+public:
+    CTimer()
+        : m_Start(std::chrono::steady_clock::now())
+    {
+    }
+
+    double GetSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_Start;
+};
+
+void PrintSpeed(const std::uint64_t nodes, const double seconds)
+{
+    const double nps = (seconds > 0.0) ? static_cast<double>(nodes) / seconds : 0.0;
+
+    std::printf("nodes %llu, time %.3f s, %.0f nps\n", static_cast<unsigned long long>(nodes), seconds, nps);
+}
+
+bool LoadGame(CChessGame & game, const char * fen)
+{
+    if (game.SetFEN(fen))
+        return true;
+
+    std::printf("invalid FEN: %s\n", fen);
+
+    return false;
+}
+
+int RunPerft(const int depth, const char * fen, const bool isDivide)
+{
+    CChessGame game;
+    if (!LoadGame(game, fen))
+        return 1;
+
+    const CTimer timer;
+
+    std::uint64_t nodes = 0;
+
+    if (isDivide && depth > 0)
+    {
+        CMoveList moves;
+        game.GenerateLegalMoves(moves);
+
+        CUndoInfo undo;
+
+        for (const auto & mv : moves)
+        {
+            game.MakeMove(mv, undo);
+
+            const auto moveNodes = Perft(game, depth - 1);
+
+            game.UnmakeMove(mv, undo);
+
+            std::printf("%s: %llu\n", game.GetMoveName(mv).c_str(), static_cast<unsigned long long>(moveNodes));
+
+            nodes += moveNodes;
+        }
+
+        std::printf("\n");
+    }
+    else
+        nodes = Perft(game, depth);
+
+    PrintSpeed(nodes, timer.GetSeconds());
+
+    return 0;
+}
+
+int RunSuite(const int maxDepth)
+{
+    int numFailed = 0;
+
+    std::uint64_t totalNodes = 0;
+
+    const CTimer totalTimer;
+
+    for (const auto & position : s_ReferencePositions)
+    {
+        CChessGame game;
+        if (!LoadGame(game, position.m_FEN))
+            return 1;
+
+        if (game.GetFEN() != position.m_FEN)
+        {
+            std::printf("%-10s FEN round trip FAILED: %s\n", position.m_Name, game.GetFEN().c_str());
+
+            ++numFailed;
+        }
+
+        const auto rootHash = game.GetHash();
+
+        for (int depth = 1; depth <= maxDepth && depth <= 6; ++depth)
+        {
+            const auto expected = position.m_Nodes[depth - 1];
+            if (expected == 0)
+                break;
+
+            const auto nodes = Perft(game, depth);
+
+            totalNodes += nodes;
+
+            if (game.GetFEN() != position.m_FEN)
+            {
+                std::printf("%-10s position not restored after depth %d: %s\n", position.m_Name, depth, game.GetFEN().c_str());
+
+                ++numFailed;
+            }
+
+            if (game.GetHash() != rootHash)
+            {
+                std::printf("%-10s hash not restored after depth %d\n", position.m_Name, depth);
+
+                ++numFailed;
+            }
+
+            const bool isOk = nodes == expected;
+
+            std::printf("%-10s depth %d: %12llu %s\n", position.m_Name, depth, static_cast<unsigned long long>(nodes), isOk ? "ok" : "FAILED");
+
+            if (!isOk)
+            {
+                std::printf("           expected %llu\n", static_cast<unsigned long long>(expected));
+
+                ++numFailed;
+            }
+        }
+    }
+
+    PrintSpeed(totalNodes, totalTimer.GetSeconds());
+
+    std::printf("%s\n", (numFailed == 0) ? "all passed" : "FAILED");
+
+    return (numFailed == 0) ? 0 : 1;
+}
+
+int RunFENBenchmark(const int iterations)
+{
+    CChessGame game;
+
+    std::uint64_t numLoaded = 0;
+
+    const CTimer timer;
+
+    for (int i = 0; i < iterations; ++i)
+        for (const auto & position : s_ReferencePositions)
+            if (game.SetFEN(position.m_FEN))
+                ++numLoaded;
+
+    const double seconds = timer.GetSeconds();
+
+    const double fensPerSecond = (seconds > 0.0) ? static_cast<double>(numLoaded) / seconds : 0.0;
+
+    std::printf("FENs %llu, time %.3f s, %.0f FENs per second\n", static_cast<unsigned long long>(numLoaded), seconds, fensPerSecond);
+
+    return 0;
+}
+
+int RunSANBenchmark(const int iterations)
+{
+    struct CPositionMoves
+    {
+        CChessGame  m_Game;
+        CMoveList   m_Moves;
+        char        m_SANs[CMoveList::s_MaxMoves][CChessGame::s_MaxSANLength];
+        std::size_t m_Lengths[CMoveList::s_MaxMoves];
+    };
+
+    std::vector<CPositionMoves> positions(sizeof(s_ReferencePositions) / sizeof(s_ReferencePositions[0]));
+
+    for (std::size_t i = 0; i < positions.size(); ++i)
+    {
+        if (!LoadGame(positions[i].m_Game, s_ReferencePositions[i].m_FEN))
+            return 1;
+
+        positions[i].m_Game.GenerateLegalMoves(positions[i].m_Moves);
+    }
+
+    std::uint64_t numMoves = 0;
+
+    const CTimer writeTimer;
+
+    for (int i = 0; i < iterations; ++i)
+        for (auto & position : positions)
+            for (std::size_t m = 0; m < position.m_Moves.GetSize(); ++m)
+            {
+                position.m_Lengths[m] = position.m_Game.GetMoveSAN(position.m_Moves[m], position.m_SANs[m]);
+
+                ++numMoves;
+            }
+
+    const double writeSeconds = writeTimer.GetSeconds();
+
+    int numFailed = 0;
+
+    const CTimer readTimer;
+
+    for (int i = 0; i < iterations; ++i)
+        for (auto & position : positions)
+            for (std::size_t m = 0; m < position.m_Moves.GetSize(); ++m)
+                if (position.m_Game.GetMoveBySAN(position.m_SANs[m], position.m_Lengths[m]) != position.m_Moves[m] && i == 0)
+                {
+                    std::printf("round trip FAILED: %s in %s\n", position.m_SANs[m], position.m_Game.GetFEN().c_str());
+
+                    ++numFailed;
+                }
+
+    const double readSeconds = readTimer.GetSeconds();
+
+    std::printf("moves %llu, write %.3f s, %.0f moves per second, read %.3f s, %.0f moves per second\n",
+                static_cast<unsigned long long>(numMoves),
+                writeSeconds, (writeSeconds > 0.0) ? static_cast<double>(numMoves) / writeSeconds : 0.0,
+                readSeconds,  (readSeconds > 0.0)  ? static_cast<double>(numMoves) / readSeconds  : 0.0);
+
+    std::printf("%s\n", (numFailed == 0) ? "all passed" : "FAILED");
+
+    return (numFailed == 0) ? 0 : 1;
+}
+
+int RunPGNBenchmark(const char * fileName, const int numThreads)
+{
+    CPGNStats stats;
+
+    // the positions are touched, so that the replay can't be optimized away
+    std::atomic<std::uint64_t> hashSum(0);
+
+    const CTimer timer;
+
+    const bool isRead = ReadPGNFile(fileName, [&hashSum](const CPGNGame & game)
+    {
+        hashSum += game.m_StartPosition.GetHash() + game.m_Moves.size();
+    },
+    stats, numThreads);
+
+    if (!isRead)
+    {
+        std::printf("can't read %s\n", fileName);
+
+        return 1;
+    }
+
+    const double seconds = timer.GetSeconds();
+
+    const double gamesPerSecond = (seconds > 0.0) ? static_cast<double>(stats.m_NumGames) / seconds : 0.0;
+    const double movesPerSecond = (seconds > 0.0) ? static_cast<double>(stats.m_NumMoves) / seconds : 0.0;
+
+    std::printf("games %llu, invalid %llu, moves %llu, time %.3f s, %.0f games per second, %.0f moves per second (checksum %llx)\n",
+                static_cast<unsigned long long>(stats.m_NumGames), static_cast<unsigned long long>(stats.m_NumInvalidGames),
+                static_cast<unsigned long long>(stats.m_NumMoves), seconds, gamesPerSecond, movesPerSecond,
+                static_cast<unsigned long long>(hashSum.load()));
+
+    return 0;
+}
+
+int RunPackPGN(const char * pgnFileName, const char * packedFileName, const int numThreads)
+{
+    CPGNStats stats;
+
+    std::vector<CPackedPosition> positions;
+
+    std::mutex positionsMutex;
+
+    std::uint64_t fenBytes = 0;
+
+    const bool isRead = ReadPGNFile(pgnFileName, [&](const CPGNGame & game)
+    {
+        std::vector<CPackedPosition> gamePositions(game.m_Moves.size() + 1);
+
+        std::uint64_t gameFENBytes = 0;
+
+        CChessGame position = game.m_StartPosition;
+
+        CUndoInfo undo;
+
+        for (std::size_t i = 0; i < gamePositions.size(); ++i)
+        {
+            if (i > 0)
+                position.MakeMove(game.m_Moves[i - 1], undo);
+
+            position.GetPackedPosition(gamePositions[i]);
+
+            gameFENBytes += position.GetFEN().size() + 1; // with the line end
+        }
+
+        // the games of the threads end up interleaved
+        std::lock_guard<std::mutex> lock(positionsMutex);
+
+        positions.insert(positions.end(), gamePositions.begin(), gamePositions.end());
+
+        fenBytes += gameFENBytes;
+    },
+    stats, numThreads);
+
+    if (!isRead)
+    {
+        std::printf("can't read %s\n", pgnFileName);
+
+        return 1;
+    }
+
+    std::ofstream file(packedFileName, std::ios::binary);
+
+    file.write(reinterpret_cast<const char *>(positions.data()), positions.size() * sizeof(CPackedPosition));
+
+    if (!file)
+    {
+        std::printf("can't write %s\n", packedFileName);
+
+        return 1;
+    }
+
+    std::printf("games %llu, invalid %llu, positions %llu, %llu bytes (%llu bytes as FEN)\n",
+                static_cast<unsigned long long>(stats.m_NumGames), static_cast<unsigned long long>(stats.m_NumInvalidGames),
+                static_cast<unsigned long long>(positions.size()),
+                static_cast<unsigned long long>(positions.size() * sizeof(CPackedPosition)),
+                static_cast<unsigned long long>(fenBytes));
+
+    return 0;
+}
+
+int RunPackedBenchmark(const char * fileName, const int numThreads)
+{
+    CPackedPositionFile file;
+    if (!file.Open(fileName))
+    {
+        std::printf("can't read %s\n", fileName);
+
+        return 1;
+    }
+
+    CPackedPositionStats stats;
+
+    // every position is packed again and compared with its record, which also keeps the decoding from being optimized away
+    std::atomic<std::uint64_t> hashSum(0);
+    std::atomic<std::uint64_t> numMismatches(0);
+
+    const CTimer timer;
+
+    DecodePackedPositions(file, 0, file.GetNumPositions(), [&](const std::size_t index, const CChessGame & game)
+    {
+        const auto & record = file.GetPackedPosition(index);
+
+        CPackedPosition packed = record;
+
+        game.GetPackedPosition(packed);
+
+        if (std::memcmp(&packed, &record, sizeof(packed)) != 0)
+            ++numMismatches;
+
+        hashSum += game.GetHash();
+    },
+    stats, numThreads);
+
+    const double seconds = timer.GetSeconds();
+
+    const double positionsPerSecond = (seconds > 0.0) ? static_cast<double>(stats.m_NumPositions) / seconds : 0.0;
+
+    std::printf("positions %llu, invalid %llu, mismatches %llu, time %.3f s, %.0f positions per second (checksum %llx)\n",
+                static_cast<unsigned long long>(stats.m_NumPositions), static_cast<unsigned long long>(stats.m_NumInvalidPositions),
+                static_cast<unsigned long long>(numMismatches.load()), seconds, positionsPerSecond,
+                static_cast<unsigned long long>(hashSum.load()));
+
+    return (stats.m_NumInvalidPositions == 0 && numMismatches == 0) ? 0 : 1;
+}
+
+// a non-negative decimal number, the whole argument
+bool ParseCount(const char * arg, int & count)
+{
+    if (!std::isdigit(static_cast<unsigned char>(*arg)))
+        return false;
+
+    char * end = nullptr;
+
+    errno = 0;
+
+    const long value = std::strtol(arg, &end, 10);
+
+    if (*end != '\0' || errno == ERANGE || value > INT_MAX)
+        return false;
+
+    count = static_cast<int>(value);
+
+    return true;
+}
+
+// the argument at the index if there is one, else the default
+bool ParseOptionalCount(const int argc, char * argv[], const int index, const int defaultCount, int & count)
+{
+    if (index >= argc)
+    {
+        count = defaultCount;
+
+        return true;
+    }
+
+    return ParseCount(argv[index], count);
+}
+
+void PrintUsage()
+{
+    std::printf("usage:\n"
+                "  Perft <depth> [fen]          count leaf nodes (startpos by default)\n"
+                "  Perft -divide <depth> [fen]  leaf nodes per root move\n"
+                "  Perft -suite [maxDepth]      verify the reference positions (maxDepth 4 by default)\n"
+                "  Perft -fenbench [iterations] measure FEN loading throughput\n"
+                "  Perft -sanbench [iterations] measure SAN writing and reading throughput\n"
+                "  Perft -pgnbench <file> [threads] measure PGN reading and validation throughput\n"
+                "  Perft -pack <pgn> <output> [threads] write every position of the games as packed records\n"
+                "  Perft -packbench <file> [threads] measure packed position decoding throughput and verify the round trip\n");
+}
+
+} // namespace
+
+} // namespace ChessProj
+
+int main(int argc, char * argv[])
+{
+    using namespace ChessProj;
+
+    if (argc < 2)
+    {
+        PrintUsage();
+
+        return 1;
+    }
+
+    // an option with a malformed number falls through to the depth, which it isn't either
+    int count = 0;
+
+    if (std::strcmp(argv[1], "-suite") == 0 && argc <= 3 && ParseOptionalCount(argc, argv, 2, 4, count))
+        return RunSuite(count);
+
+    if (std::strcmp(argv[1], "-fenbench") == 0 && argc <= 3 && ParseOptionalCount(argc, argv, 2, 1000000, count))
+        return RunFENBenchmark(count);
+
+    if (std::strcmp(argv[1], "-sanbench") == 0 && argc <= 3 && ParseOptionalCount(argc, argv, 2, 10000, count))
+        return RunSANBenchmark(count);
+
+    if (std::strcmp(argv[1], "-pgnbench") == 0 && argc > 2 && argc <= 4 && ParseOptionalCount(argc, argv, 3, 0, count))
+        return RunPGNBenchmark(argv[2], count);
+
+    if (std::strcmp(argv[1], "-pack") == 0 && argc > 3 && argc <= 5 && ParseOptionalCount(argc, argv, 4, 0, count))
+        return RunPackPGN(argv[2], argv[3], count);
+
+    if (std::strcmp(argv[1], "-packbench") == 0 && argc > 2 && argc <= 4 && ParseOptionalCount(argc, argv, 3, 0, count))
+        return RunPackedBenchmark(argv[2], count);
+
+    const bool isDivide = std::strcmp(argv[1], "-divide") == 0;
+
+    const int depthArg = isDivide ? 2 : 1;
+
+    int depth = 0;
+
+    if (argc <= depthArg || !ParseCount(argv[depthArg], depth))
+    {
+        PrintUsage();
+
+        return 1;
+    }
+
+    std::string fen = s_StartFEN;
+
+    if (argc > depthArg + 1)
+    {
+        // the FEN may be passed either quoted or as separate arguments
+        fen.clear();
+
+        for (int i = depthArg + 1; i < argc; ++i)
+        {
+            if (!fen.empty())
+                fen += ' ';
+
+            fen += argv[i];
+        }
+    }
+
+    return RunPerft(depth, fen.c_str(), isDivide);
+}
\ No newline at end of file
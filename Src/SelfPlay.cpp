@@ -0,0 +1,670 @@
+#include "ChessBook.h"
+#include "ChessGame.h"
+#include "ChessNNUE.h"
+#include "ChessSearch.h"
+#include "ChessTablebase.h"
+#include "ChessTransTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ChessProj
+{
+
+namespace
+{
+
+const char * s_StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// a game still going after this many plies is adjudicated a draw
+const int s_MaxGamePlies = 400;
+
+// random plies played from the openings when there are fewer of them than game pairs
+const int s_DefaultRandomPlies = 8;
+
+const int s_DefaultNodes  = 10000;
+const int s_DefaultHashMB = 4;
+
+// a progress line after this many finished games
+const int s_ReportInterval = 100;
+
+// one side of the match. The two configurations differ by the evaluation and the search limits
+struct CEngineConfig
+{
+    std::string     m_Spec;                 // as given on the command line, for the report
+    std::string     m_EvalFile;             // NNUE weights, empty for the handcrafted evaluation
+    CSearchLimits   m_Limits;
+    int             m_HashMB = s_DefaultHashMB;
+    CNNUENetwork    m_Network;              // loaded once, shared by all the workers
+    std::string     m_BookFile;             // a Polyglot book, its moves are played without a search
+    std::string     m_BookKeysFile;         // the random table of the book keys, empty for the default one
+    CPolyglotBook   m_Book;                 // shared by all the workers too
+    std::string     m_TablebasePath;        // the directory of the endgame tables, empty for none
+    CTablebases     m_Tablebases;           // shared by all the workers as well
+};
+
+struct CMatchConfig
+{
+    std::vector<std::string>    m_Openings;
+    int                         m_NumGames   = 1000;    // rounded up to pairs: each opening is played with both colors
+    int                         m_NumWorkers = 0;       // 0 = one per hardware thread
+
+    // played from the opening before a pair, the same for both games. The searches are deterministic, so without
+    // them a pair replaying an opening replays the same games. -1 = s_DefaultRandomPlies if the openings wrap, else 0
+    int                         m_NumRandomPlies = -1;
+
+    // SPRT of H0: elo = m_Elo0 against H1: elo = m_Elo1, from the first engine's point of view
+    double                      m_Elo0  = 0.0;
+    double                      m_Elo1  = 5.0;
+    double                      m_Alpha = 0.05;
+    double                      m_Beta  = 0.05;
+};
+
+enum class GameResult
+{
+    FirstWon,
+    Draw,
+    SecondWon
+};
+
+// the counts are from the first engine's point of view
+struct CMatchResults
+{
+    int     m_Wins   = 0;
+    int     m_Draws  = 0;
+    int     m_Losses = 0;
+
+    int GetNumGames() const
+    {
+        return m_Wins + m_Draws + m_Losses;
+    }
+
+    double GetScore() const
+    {
+        return (m_Wins + 0.5 * m_Draws) / GetNumGames();
+    }
+
+    // of the score of a single game
+    double GetVariance() const
+    {
+        const double n = GetNumGames();
+
+        const double score = GetScore();
+
+        return (m_Wins / n) * (1.0 - score) * (1.0 - score) +
+               (m_Draws / n) * (0.5 - score) * (0.5 - score) +
+               (m_Losses / n) * score * score;
+    }
+};
+
+double GetEloFromScore(const double score)
+{
+    const double clamped = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+
+    return -400.0 * std::log10(1.0 / clamped - 1.0);
+}
+
+double GetScoreFromElo(const double elo)
+{
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// log-likelihood ratio of H1 against H0 in the normal approximation of the trinomial model
+double GetLLR(const CMatchResults & results, const double elo0, const double elo1)
+{
+    if (results.GetNumGames() == 0)
+        return 0.0;
+
+    const double variance = results.GetVariance();
+
+    if (variance <= 0.0)
+        return 0.0; // all the games ended the same, the variance can't be estimated yet
+
+    const double score0 = GetScoreFromElo(elo0);
+    const double score1 = GetScoreFromElo(elo1);
+
+    return results.GetNumGames() * (score1 - score0) * (2.0 * results.GetScore() - score0 - score1) / (2.0 * variance);
+}
+
+bool IsInsufficientMaterial(const CChessBoard & board)
+{
+    const auto pieces = board.GetOccupiedBB() & ~board.GetTypeBB(CChessPiece::Type::King);
+
+    if (pieces == 0)
+        return true;
+
+    // a single minor piece can't mate
+    if (PopCount(pieces) == 1)
+        return (pieces & (board.GetTypeBB(CChessPiece::Type::Knight) | board.GetTypeBB(CChessPiece::Type::Bishop))) != 0;
+
+    return false;
+}
+
+// the position has occurred at least twice before, since the last irreversible move
+bool IsThreefoldRepetition(const CChessGame & game, const std::vector<std::uint64_t> & hashes)
+{
+    const int numPositions = static_cast<int>(hashes.size());
+
+    const int firstPosition = std::max(0, numPositions - 1 - game.GetHalfMoveClock());
+
+    int count = 0;
+
+    for (int i = numPositions - 3; i >= firstPosition; i -= 2)
+        if (hashes[i] == hashes.back())
+            ++count;
+
+    return count >= 2;
+}
+
+// the opening after the random plies, picked by a generator seeded with the pair index. A move ending
+// the game is not picked, the plies stop early if every move does
+std::string GetPairOpening(const std::string & opening, const int numRandomPlies, const int pairIndex)
+{
+    if (numRandomPlies == 0)
+        return opening;
+
+    std::mt19937_64 random(pairIndex);
+
+    CChessGame game;
+    game.SetFEN(opening.c_str());
+
+    for (int ply = 0; ply < numRandomPlies; ++ply)
+    {
+        CMoveList moves;
+        game.GenerateLegalMoves(moves);
+
+        std::vector<CChessMove> candidates;
+
+        for (const auto & mv : moves)
+        {
+            auto next = game;
+            next.Move(mv, mv.GetPromotion());
+
+            if (next.GetState() == CChessGame::State::Active)
+                candidates.push_back(mv);
+        }
+
+        if (candidates.empty())
+            break;
+
+        const auto & mv = candidates[random() % candidates.size()];
+
+        game.Move(mv, mv.GetPromotion());
+    }
+
+    return game.GetFEN();
+}
+
+// the searches and the tables of both engines, owned by one worker thread
+class CWorker
+{
+public:
+    explicit CWorker(CEngineConfig * engines)
+        : m_Engines(engines)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            m_TransTables[i].reset(new CTransTable(engines[i].m_HashMB));
+            m_Searches[i].reset(new CSearch(*m_TransTables[i]));
+
+            m_Searches[i]->SetNetwork(engines[i].m_EvalFile.empty() ? nullptr : &engines[i].m_Network);
+            m_Searches[i]->SetTablebases(engines[i].m_TablebasePath.empty() ? nullptr : &engines[i].m_Tablebases);
+        }
+    }
+
+    // the game is abandoned (returning false) as soon as the stop flag is set. The book moves are picked
+    // by a generator seeded with bookSeed, so that the games with the same seed take the same book lines
+    bool PlayGame(const std::string & opening, const bool isFirstWhite, const std::uint64_t bookSeed, const std::atomic<bool> & isStopped,
+                  GameResult & result)
+    {
+        std::mt19937_64 bookRandom(bookSeed);
+
+        CChessGame game;
+        game.SetFEN(opening.c_str());
+
+        for (auto & transTable : m_TransTables)
+            transTable->Clear();
+
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(s_MaxGamePlies + 1);
+        hashes.push_back(game.GetHash());
+
+        for (int ply = 0; ply < s_MaxGamePlies; ++ply)
+        {
+            if (isStopped)
+                return false;
+
+            switch (game.GetState())
+            {
+            case CChessGame::State::WhiteWon:
+                result = isFirstWhite ? GameResult::FirstWon : GameResult::SecondWon;
+                return true;
+
+            case CChessGame::State::BlackWon:
+                result = isFirstWhite ? GameResult::SecondWon : GameResult::FirstWon;
+                return true;
+
+            case CChessGame::State::Draw:
+                result = GameResult::Draw;
+                return true;
+
+            case CChessGame::State::Active:
+                break;
+            }
+
+            if (game.GetHalfMoveClock() >= 100 || IsThreefoldRepetition(game, hashes) || IsInsufficientMaterial(game.GetBoard()))
+            {
+                result = GameResult::Draw;
+                return true;
+            }
+
+            const bool isWhiteToMove = game.GetCurrentMoveColor() == CChessPiece::Color::White;
+
+            const int engine = (isWhiteToMove == isFirstWhite) ? 0 : 1;
+
+            // drawn every ply, so that the picks of the two games of a pair stay in step
+            const auto random = bookRandom();
+
+            auto mv = m_Engines[engine].m_Book.IsOpen() ? m_Engines[engine].m_Book.PickMove(game, random) : CChessMove();
+
+            if (!mv.IsValid())
+                mv = m_Searches[engine]->Search(game, m_Engines[engine].m_Limits, hashes).m_BestMove;
+
+            game.Move(mv, mv.GetPromotion());
+
+            hashes.push_back(game.GetHash());
+        }
+
+        result = GameResult::Draw;
+
+        return true;
+    }
+
+private:
+    CEngineConfig *                 m_Engines;
+    std::unique_ptr<CTransTable>    m_TransTables[2];
+    std::unique_ptr<CSearch>        m_Searches[2];
+};
+
+class CMatch
+{
+public:
+    CMatch(CMatchConfig & config, CEngineConfig * engines)
+        : m_Config(config)
+        , m_Engines(engines)
+        , m_NextGame(0)
+        , m_IsStopped(false)
+    {
+    }
+
+    int Run()
+    {
+        const int numWorkers = (m_Config.m_NumWorkers > 0) ? m_Config.m_NumWorkers : std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+
+        m_LowerBound = std::log(m_Config.m_Beta / (1.0 - m_Config.m_Alpha));
+        m_UpperBound = std::log((1.0 - m_Config.m_Beta) / m_Config.m_Alpha);
+
+        std::printf("%d games, %d workers, %d openings, %d random plies\n",
+                    m_Config.m_NumGames, numWorkers, static_cast<int>(m_Config.m_Openings.size()), m_Config.m_NumRandomPlies);
+        std::printf("first:  %s\nsecond: %s\n", m_Engines[0].m_Spec.c_str(), m_Engines[1].m_Spec.c_str());
+        std::printf("SPRT: elo0 %.1f, elo1 %.1f, alpha %.3f, beta %.3f, LLR bounds [%.2f, %.2f]\n",
+                    m_Config.m_Elo0, m_Config.m_Elo1, m_Config.m_Alpha, m_Config.m_Beta, m_LowerBound, m_UpperBound);
+
+        m_StartTime = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> workers;
+
+        for (int i = 0; i < numWorkers; ++i)
+            workers.emplace_back([this]() { RunWorker(); });
+
+        for (auto & worker : workers)
+            worker.join();
+
+        std::printf("\n");
+
+        PrintResults();
+
+        const double llr = GetLLR(m_Results, m_Config.m_Elo0, m_Config.m_Elo1);
+
+        if (llr >= m_UpperBound)
+            std::printf("H1 accepted\n");
+        else
+        if (llr <= m_LowerBound)
+            std::printf("H0 accepted\n");
+        else
+            std::printf("inconclusive\n");
+
+        return 0;
+    }
+
+private:
+    // the workers take the next game from the shared counter, so that a worker that finishes early takes more of them
+    void RunWorker()
+    {
+        CWorker worker(m_Engines);
+
+        const auto & openings = m_Config.m_Openings;
+
+        while (!m_IsStopped)
+        {
+            const int gameIndex = m_NextGame++;
+            if (gameIndex >= m_Config.m_NumGames)
+                break;
+
+            const int pairIndex = gameIndex / 2;
+
+            // both colors of an opening in a row
+            const auto opening = GetPairOpening(openings[pairIndex % openings.size()], m_Config.m_NumRandomPlies, pairIndex);
+
+            const bool isFirstWhite = (gameIndex % 2) == 0;
+
+            GameResult result;
+
+            // both games of a pair get the same seed, so with the same book they open alike with the colors swapped
+            if (worker.PlayGame(opening, isFirstWhite, pairIndex, m_IsStopped, result))
+                AddResult(result);
+        }
+    }
+
+    void AddResult(const GameResult result)
+    {
+        std::lock_guard<std::mutex> lock(m_ResultsMutex);
+
+        switch (result)
+        {
+        case GameResult::FirstWon:  ++m_Results.m_Wins;   break;
+        case GameResult::Draw:      ++m_Results.m_Draws;  break;
+        case GameResult::SecondWon: ++m_Results.m_Losses; break;
+        }
+
+        const double llr = GetLLR(m_Results, m_Config.m_Elo0, m_Config.m_Elo1);
+
+        if (llr >= m_UpperBound || llr <= m_LowerBound)
+            m_IsStopped = true;
+
+        if (m_Results.GetNumGames() % s_ReportInterval == 0 || m_IsStopped)
+            PrintResults();
+    }
+
+    void PrintResults() const
+    {
+        const int numGames = m_Results.GetNumGames();
+        if (numGames == 0)
+            return;
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_StartTime).count();
+
+        const double score = m_Results.GetScore();
+
+        // 95% confidence interval of the score
+        const double margin = 1.96 * std::sqrt(m_Results.GetVariance() / numGames);
+
+        const double elo      = GetEloFromScore(score);
+        const double eloLower = GetEloFromScore(score - margin);
+        const double eloUpper = GetEloFromScore(score + margin);
+
+        std::printf("games %d: +%d =%d -%d, score %.1f%%, elo %+.1f [%+.1f, %+.1f], LLR %.2f, %.2f games/s\n",
+                    numGames, m_Results.m_Wins, m_Results.m_Draws, m_Results.m_Losses, score * 100.0,
+                    elo, eloLower, eloUpper, GetLLR(m_Results, m_Config.m_Elo0, m_Config.m_Elo1),
+                    (seconds > 0.0) ? numGames / seconds : 0.0);
+
+        std::fflush(stdout);
+    }
+
+    CMatchConfig &                          m_Config;
+    CEngineConfig *                         m_Engines;
+    std::atomic<int>                        m_NextGame;
+    std::atomic<bool>                       m_IsStopped;
+    std::mutex                              m_ResultsMutex;
+    CMatchResults                           m_Results;
+    double                                  m_LowerBound = 0.0;
+    double                                  m_UpperBound = 0.0;
+    std::chrono::steady_clock::time_point   m_StartTime;
+};
+
+// "eval=<file>,nodes=<n>,depth=<n>,movetime=<ms>,hash=<MB>,book=<file>,bookkeys=<file>,tb=<directory>", every key is optional
+bool ParseEngineConfig(const char * spec, CEngineConfig & config)
+{
+    config.m_Spec = spec;
+
+    config.m_Limits.m_MaxNodes = s_DefaultNodes;
+
+    std::istringstream input(spec);
+
+    std::string item;
+
+    while (std::getline(input, item, ','))
+    {
+        const auto separator = item.find('=');
+        if (separator == std::string::npos)
+            return false;
+
+        const auto key   = item.substr(0, separator);
+        const auto value = item.substr(separator + 1);
+
+        if (key == "eval")
+            config.m_EvalFile = value;
+        else
+        if (key == "nodes")
+            config.m_Limits.m_MaxNodes = std::strtoull(value.c_str(), nullptr, 10);
+        else
+        if (key == "depth")
+            config.m_Limits.m_MaxDepth = std::atoi(value.c_str());
+        else
+        if (key == "movetime")
+            config.m_Limits.m_MaxTimeMs = std::atoi(value.c_str());
+        else
+        if (key == "hash")
+            config.m_HashMB = std::max(std::atoi(value.c_str()), 1);
+        else
+        if (key == "book")
+            config.m_BookFile = value;
+        else
+        if (key == "bookkeys")
+            config.m_BookKeysFile = value;
+        else
+        if (key == "tb")
+            config.m_TablebasePath = value;
+        else
+            return false;
+    }
+
+    if (!config.m_EvalFile.empty() && !config.m_Network.Load(config.m_EvalFile.c_str()))
+    {
+        std::printf("can't load the network %s\n", config.m_EvalFile.c_str());
+
+        return false;
+    }
+
+    if (!config.m_BookFile.empty() &&
+        !config.m_Book.Open(config.m_BookFile.c_str(), config.m_BookKeysFile.empty() ? nullptr : config.m_BookKeysFile.c_str()))
+    {
+        std::printf("can't load the book %s\n", config.m_BookFile.c_str());
+
+        return false;
+    }
+
+    if (!config.m_TablebasePath.empty() && config.m_Tablebases.Load(config.m_TablebasePath.c_str()) == 0)
+    {
+        std::printf("no tablebases in %s\n", config.m_TablebasePath.c_str());
+
+        return false;
+    }
+
+    return true;
+}
+
+// one position per line, FEN or EPD: the operations after the first four fields of an EPD line are ignored
+bool LoadOpenings(const char * fileName, std::vector<std::string> & openings)
+{
+    std::ifstream file(fileName);
+    if (!file)
+    {
+        std::printf("can't open %s\n", fileName);
+
+        return false;
+    }
+
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        std::istringstream input(line);
+
+        std::string fen, field;
+
+        for (int i = 0; i < 6 && input >> field; ++i)
+        {
+            // the move counters of a FEN
+            if (i >= 4 && field.find_first_not_of("0123456789") != std::string::npos)
+                break;
+
+            fen += (fen.empty() ? "" : " ") + field;
+        }
+
+        if (fen.empty())
+            continue;
+
+        CChessGame game;
+
+        if (!game.SetFEN(fen.c_str()) || game.GetState() != CChessGame::State::Active)
+        {
+            std::printf("skipping the opening %s\n", fen.c_str());
+
+            continue;
+        }
+
+        openings.push_back(fen);
+    }
+
+    if (openings.empty())
+    {
+        std::printf("no openings in %s\n", fileName);
+
+        return false;
+    }
+
+    return true;
+}
+
+void PrintUsage()
+{
+    std::printf("usage: SelfPlay [options]\n"
+                "  -first <spec>       the engine under test (nodes=%d by default)\n"
+                "  -second <spec>      the reference engine\n"
+                "                      spec: eval=<nnue file>,nodes=<n>,depth=<n>,movetime=<ms>,hash=<MB>,\n"
+                "                            book=<polyglot file>,bookkeys=<random table file>,tb=<tablebase directory>\n"
+                "  -openings <file>    FEN or EPD positions, one per line (the start position by default)\n"
+                "  -games <n>          maximum number of games (1000 by default)\n"
+                "  -randomplies <n>    random plies from the opening, the same for both games of a pair\n"
+                "                      (%d by default if the games are more than twice the openings, else 0)\n"
+                "  -workers <n>        concurrent games (one per hardware thread by default)\n"
+                "  -sprt <elo0> <elo1> hypotheses of the first engine's elo difference (0 5 by default)\n"
+                "  -alpha <a> -beta <b> error probabilities of the SPRT (0.05 by default)\n",
+                s_DefaultNodes, s_DefaultRandomPlies);
+}
+
+} // namespace
+
+} // namespace ChessProj
+
+int main(int argc, char * argv[])
+{
+    using namespace ChessProj;
+
+    CMatchConfig config;
+
+    CEngineConfig engines[2];
+
+    bool isSpecified[2] = { false, false };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char * arg = argv[i];
+
+        const bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(arg, "-first") == 0 && hasValue)
+            isSpecified[0] = ParseEngineConfig(argv[++i], engines[0]);
+        else
+        if (std::strcmp(arg, "-second") == 0 && hasValue)
+            isSpecified[1] = ParseEngineConfig(argv[++i], engines[1]);
+        else
+        if (std::strcmp(arg, "-openings") == 0 && hasValue)
+        {
+            if (!LoadOpenings(argv[++i], config.m_Openings))
+                return 1;
+        }
+        else
+        if (std::strcmp(arg, "-games") == 0 && hasValue)
+            config.m_NumGames = std::atoi(argv[++i]);
+        else
+        if (std::strcmp(arg, "-randomplies") == 0 && hasValue)
+            config.m_NumRandomPlies = std::max(std::atoi(argv[++i]), 0);
+        else
+        if (std::strcmp(arg, "-workers") == 0 && hasValue)
+            config.m_NumWorkers = std::atoi(argv[++i]);
+        else
+        if (std::strcmp(arg, "-sprt") == 0 && i + 2 < argc)
+        {
+            config.m_Elo0 = std::atof(argv[++i]);
+            config.m_Elo1 = std::atof(argv[++i]);
+        }
+        else
+        if (std::strcmp(arg, "-alpha") == 0 && hasValue)
+            config.m_Alpha = std::atof(argv[++i]);
+        else
+        if (std::strcmp(arg, "-beta") == 0 && hasValue)
+            config.m_Beta = std::atof(argv[++i]);
+        else
+        {
+            PrintUsage();
+
+            return 1;
+        }
+    }
+
+    if (!isSpecified[0] || !isSpecified[1])
+    {
+        PrintUsage();
+
+        return 1;
+    }
+
+    if (config.m_Openings.empty())
+        config.m_Openings.push_back(s_StartFEN);
+
+    config.m_NumGames += config.m_NumGames % 2;
+
+    const int numPairs = config.m_NumGames / 2;
+
+    const int numOpenings = static_cast<int>(config.m_Openings.size());
+
+    if (config.m_NumRandomPlies < 0)
+        config.m_NumRandomPlies = (numPairs > numOpenings) ? s_DefaultRandomPlies : 0;
+
+    // the same start replays the same games, their results would be counted as independent
+    if (config.m_NumRandomPlies == 0 && numPairs > numOpenings)
+    {
+        std::printf("%d games need %d openings without random plies, there are %d: give more openings, fewer games or -randomplies\n",
+                    config.m_NumGames, numPairs, numOpenings);
+
+        return 1;
+    }
+
+    CMatch match(config, engines);
+
+    return match.Run();
+}
\ No newline at end of file
@@ -0,0 +1,556 @@
+#include "ChessBook.h"
+#include "ChessGame.h"
+#include "ChessNNUE.h"
+#include "ChessSearch.h"
+#include "ChessTablebase.h"
+#include "ChessTransTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ChessProj
+{
+
+namespace
+{
+
+const char * s_EngineName = "ChessProj";
+const char * s_StartFEN   = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+const int s_DefaultHashMB   = 16;
+const int s_MaxHashMB       = 65536;
+const int s_MaxThreads      = 256;
+
+// kept in reserve for the lag between the engine and the GUI
+const int s_MoveOverheadMs  = 30;
+
+// the remaining time is shared by this many moves when the GUI doesn't say
+const int s_DefaultMovesToGo = 30;
+
+const int s_DefaultBenchDepth = 8;
+
+// searched by "bench", for comparing the speed of builds and evaluations
+const char * s_BenchFENs[] =
+{
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10"
+};
+
+// the UCI protocol over stdin and stdout. The search runs on its own thread, so that "stop" and "isready"
+// are answered while it thinks
+class CUCIEngine
+{
+public:
+    CUCIEngine();
+
+    // reads the commands until "quit" or the end of the input
+    int Run();
+
+private:
+    void HandleUCI();
+    void HandleSetOption(std::istringstream & input);
+    void HandlePosition(std::istringstream & input);
+    void HandleGo(std::istringstream & input);
+    void HandleBench(std::istringstream & input);
+
+    void StopSearch();
+
+    // with the current BookFile and BookKeysFile options
+    void OpenBook();
+
+    // the table is allocated on the first search, so that idle instances stay small
+    void ResizeTransTable();
+
+    void PrintInfo(const CSearchResult & result);
+    void PrintBestMove(const CSearchResult & result);
+    void Print(const std::string & line);
+
+    CTransTable         m_TransTable;
+    CParallelSearch     m_Search;
+    CNNUENetwork        m_Network;
+    bool                m_IsNetworkUsed = false;
+
+    CPolyglotBook       m_Book;
+    std::string         m_BookFile;
+    std::string         m_BookKeysFile;
+    std::mt19937_64     m_BookRandom;       // default seeded, so that a session picks the same book moves every time
+
+    CTablebases         m_Tablebases;
+
+    CChessGame                  m_Game;
+    std::vector<std::uint64_t>  m_GameHashes;       // since the last capture or pawn move, the last one is m_Game's
+    CChessGame                  m_SearchGame;       // the searched position, "position" may change m_Game meanwhile
+    std::vector<std::uint64_t>  m_SearchHashes;
+
+    std::thread         m_SearchThread;
+    bool                m_IsInfinite = false;   // the best move is printed only after "stop"
+    CSearchResult       m_InfiniteResult;
+
+    int                 m_HashMB = s_DefaultHashMB;
+    bool                m_IsHashResizePending = true;
+
+    std::mutex          m_OutputMutex;
+};
+
+CUCIEngine::CUCIEngine()
+    : m_TransTable(1)
+    , m_Search(m_TransTable, 1)
+{
+    m_Game.SetFEN(s_StartFEN);
+
+    m_GameHashes.assign(1, m_Game.GetHash());
+
+    m_Search.SetProgressCallback([this](const CSearchResult & result) { PrintInfo(result); });
+}
+
+int CUCIEngine::Run()
+{
+    std::string line;
+
+    while (std::getline(std::cin, line))
+    {
+        std::istringstream input(line);
+
+        std::string command;
+        input >> command;
+
+        if (command == "uci")
+            HandleUCI();
+        else
+        if (command == "isready")
+            Print("readyok");
+        else
+        if (command == "ucinewgame")
+        {
+            StopSearch();
+
+            m_TransTable.Clear();
+        }
+        else
+        if (command == "setoption")
+            HandleSetOption(input);
+        else
+        if (command == "position")
+            HandlePosition(input);
+        else
+        if (command == "go")
+            HandleGo(input);
+        else
+        if (command == "stop")
+            StopSearch();
+        else
+        if (command == "bench")
+            HandleBench(input);
+        else
+        if (command == "quit")
+            break;
+        else
+        if (!command.empty())
+            Print("info string unknown command: " + command);
+    }
+
+    StopSearch();
+
+    return 0;
+}
+
+void CUCIEngine::HandleUCI()
+{
+    Print(std::string("id name ") + s_EngineName);
+    Print(std::string("id author ") + s_EngineName + " developers");
+
+    Print("option name Hash type spin default " + std::to_string(s_DefaultHashMB) + " min 1 max " + std::to_string(s_MaxHashMB));
+    Print("option name Threads type spin default 1 min 1 max " + std::to_string(s_MaxThreads));
+    Print("option name EvalFile type string default <empty>");
+    Print("option name BookFile type string default <empty>");
+    Print("option name BookKeysFile type string default <empty>");
+    Print("option name TablebasePath type string default <empty>");
+
+    Print("uciok");
+}
+
+void CUCIEngine::HandleSetOption(std::istringstream & input)
+{
+    // setoption name <id> [value <x>], both may contain spaces
+    std::string token, name, value;
+
+    input >> token; // "name"
+
+    while (input >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+
+    while (input >> token)
+        value += (value.empty() ? "" : " ") + token;
+
+    StopSearch();
+
+    if (name == "Hash")
+    {
+        m_HashMB = std::min(std::max(std::atoi(value.c_str()), 1), s_MaxHashMB);
+
+        m_IsHashResizePending = true;
+    }
+    else
+    if (name == "Threads")
+        m_Search.SetNumThreads(std::min(std::max(std::atoi(value.c_str()), 1), s_MaxThreads));
+    else
+    if (name == "EvalFile")
+    {
+        if (value.empty() || value == "<empty>")
+        {
+            m_Search.SetNetwork(nullptr);
+
+            m_IsNetworkUsed = false;
+
+            Print("info string using the handcrafted evaluation");
+        }
+        else
+        if (m_Network.Load(value.c_str()))
+        {
+            m_Search.SetNetwork(&m_Network);
+
+            m_IsNetworkUsed = true;
+
+            Print(std::string("info string loaded the network ") + value + " (" + CNNUENetwork::GetSIMDName() + ")");
+        }
+        else
+            Print("info string failed to load the network " + value);
+    }
+    else
+    if (name == "BookFile" || name == "BookKeysFile")
+    {
+        auto & fileName = (name == "BookFile") ? m_BookFile : m_BookKeysFile;
+
+        fileName = (value == "<empty>") ? std::string() : value;
+
+        OpenBook();
+    }
+    else
+    if (name == "TablebasePath")
+    {
+        m_Search.SetTablebases(nullptr);
+
+        m_Tablebases.Close();
+
+        if (value.empty() || value == "<empty>")
+            return;
+
+        if (m_Tablebases.Load(value.c_str()) > 0)
+        {
+            m_Search.SetTablebases(&m_Tablebases);
+
+            Print("info string loaded " + std::to_string(m_Tablebases.GetNumTables()) + " tablebases from " + value);
+        }
+        else
+            Print("info string no tablebases in " + value);
+    }
+    else
+        Print("info string unknown option: " + name);
+}
+
+void CUCIEngine::HandlePosition(std::istringstream & input)
+{
+    std::string token;
+    input >> token;
+
+    std::string fen;
+
+    if (token == "startpos")
+    {
+        fen = s_StartFEN;
+
+        input >> token; // "moves"
+    }
+    else
+    if (token == "fen")
+    {
+        while (input >> token && token != "moves")
+            fen += (fen.empty() ? "" : " ") + token;
+    }
+    else
+        return;
+
+    // the command is applied to a copy, so that an invalid one keeps the previous position
+    CChessGame game;
+
+    if (!game.SetFEN(fen.c_str()))
+    {
+        Print("info string invalid FEN: " + fen);
+
+        return;
+    }
+
+    std::vector<std::uint64_t> gameHashes(1, game.GetHash());
+
+    if (token == "moves")
+    {
+        while (input >> token)
+        {
+            const auto mv = game.GetMoveByName(token);
+
+            if (!mv.IsValid())
+            {
+                Print("info string illegal move: " + token);
+
+                return;
+            }
+
+            game.Move(mv, mv.GetPromotion());
+
+            // the positions before a capture or pawn move cannot repeat any more
+            if (game.GetHalfMoveClock() == 0)
+                gameHashes.clear();
+
+            gameHashes.push_back(game.GetHash());
+        }
+    }
+
+    m_Game = game;
+    m_GameHashes = std::move(gameHashes);
+}
+
+void CUCIEngine::HandleGo(std::istringstream & input)
+{
+    StopSearch();
+
+    CSearchLimits limits;
+
+    int moveTime  = 0;
+    int time[2]   = { 0, 0 };   // indexed by CChessPiece::Color
+    int inc[2]    = { 0, 0 };
+    int movesToGo = 0;
+
+    m_IsInfinite = false;
+
+    std::string token;
+
+    while (input >> token)
+    {
+        if (token == "depth")
+            input >> limits.m_MaxDepth;
+        else
+        if (token == "nodes")
+            input >> limits.m_MaxNodes;
+        else
+        if (token == "movetime")
+            input >> moveTime;
+        else
+        if (token == "wtime")
+            input >> time[0];
+        else
+        if (token == "btime")
+            input >> time[1];
+        else
+        if (token == "winc")
+            input >> inc[0];
+        else
+        if (token == "binc")
+            input >> inc[1];
+        else
+        if (token == "movestogo")
+            input >> movesToGo;
+        else
+        if (token == "infinite")
+            m_IsInfinite = true;
+    }
+
+    const int side = static_cast<int>(m_Game.GetCurrentMoveColor());
+
+    if (moveTime > 0)
+        limits.m_MaxTimeMs = moveTime;
+    else
+    if (time[side] > 0 && !m_IsInfinite)
+    {
+        const int available = std::max(time[side] - s_MoveOverheadMs, 1);
+
+        const int numMoves = (movesToGo > 0) ? movesToGo : s_DefaultMovesToGo;
+
+        limits.m_MaxTimeMs = std::min(available / numMoves + inc[side], available);
+    }
+
+    m_SearchGame = m_Game;
+    m_SearchHashes = m_GameHashes;
+
+    // a book move is played at once, except in analysis
+    if (m_Book.IsOpen() && !m_IsInfinite)
+    {
+        CSearchResult result;
+        result.m_BestMove = m_Book.PickMove(m_SearchGame, m_BookRandom());
+
+        if (result.m_BestMove.IsValid())
+        {
+            Print("info string book move");
+
+            PrintBestMove(result);
+
+            return;
+        }
+    }
+
+    ResizeTransTable();
+
+    // on this thread, so that a "stop" read after "go" stops the search even before the thread has started it
+    m_Search.ResetStop();
+
+    m_SearchThread = std::thread([this, limits]()
+    {
+        const auto result = m_Search.Search(m_SearchGame, limits, m_SearchHashes);
+
+        if (m_IsInfinite)
+            m_InfiniteResult = result;
+        else
+            PrintBestMove(result);
+    });
+}
+
+void CUCIEngine::HandleBench(std::istringstream & input)
+{
+    StopSearch();
+
+    int depth = s_DefaultBenchDepth;
+    input >> depth;
+
+    ResizeTransTable();
+
+    // a single thread and no info lines, so that the node count is the same on every run
+    std::unique_ptr<CSearch> search(new CSearch(m_TransTable));
+
+    search->SetNetwork(m_IsNetworkUsed ? &m_Network : nullptr);
+
+    CSearchLimits limits;
+    limits.m_MaxDepth = depth;
+
+    std::uint64_t nodes = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (const auto * fen : s_BenchFENs)
+    {
+        CChessGame game;
+        game.SetFEN(fen);
+
+        m_TransTable.Clear();
+
+        nodes += search->Search(game, limits).m_Nodes;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto nodesPerSecond = static_cast<std::uint64_t>((seconds > 0.0) ? static_cast<double>(nodes) / seconds : 0.0);
+
+    Print("info string bench depth " + std::to_string(depth) + " nodes " + std::to_string(nodes) +
+          " time " + std::to_string(static_cast<int>(seconds * 1000.0)) + " nps " + std::to_string(nodesPerSecond));
+}
+
+void CUCIEngine::StopSearch()
+{
+    if (!m_SearchThread.joinable())
+        return;
+
+    m_Search.Stop();
+
+    m_SearchThread.join();
+
+    if (m_IsInfinite)
+    {
+        m_IsInfinite = false;
+
+        PrintBestMove(m_InfiniteResult);
+    }
+}
+
+void CUCIEngine::OpenBook()
+{
+    m_Book.Close();
+
+    if (m_BookFile.empty())
+        return;
+
+    if (m_Book.Open(m_BookFile.c_str(), m_BookKeysFile.empty() ? nullptr : m_BookKeysFile.c_str()))
+        Print("info string loaded the book " + m_BookFile + " (" + std::to_string(m_Book.GetNumEntries()) + " entries)");
+    else
+        Print("info string failed to load the book " + m_BookFile);
+}
+
+void CUCIEngine::ResizeTransTable()
+{
+    if (!m_IsHashResizePending)
+        return;
+
+    m_TransTable.Resize(m_HashMB);
+
+    m_IsHashResizePending = false;
+}
+
+void CUCIEngine::PrintInfo(const CSearchResult & result)
+{
+    std::string line = "info depth " + std::to_string(result.m_Depth);
+
+    if (CSearch::IsMateScore(result.m_Score))
+    {
+        const int moves = (CSearch::s_MateScore - std::abs(result.m_Score) + 1) / 2;
+
+        line += " score mate " + std::to_string((result.m_Score > 0) ? moves : -moves);
+    }
+    else
+        line += " score cp " + std::to_string(result.m_Score);
+
+    const auto nodesPerSecond = static_cast<std::uint64_t>((result.m_Seconds > 0.0) ? static_cast<double>(result.m_Nodes) / result.m_Seconds : 0.0);
+
+    line += " nodes "    + std::to_string(result.m_Nodes);
+    line += " nps "      + std::to_string(nodesPerSecond);
+    line += " time "     + std::to_string(static_cast<int>(result.m_Seconds * 1000.0));
+    line += " hashfull " + std::to_string(m_TransTable.GetHashFull());
+    line += " tbhits "   + std::to_string(result.m_TablebaseHits);
+
+    if (!result.m_PV.empty())
+    {
+        line += " pv";
+
+        for (const auto & mv : result.m_PV)
+            line += " " + m_SearchGame.GetMoveName(mv);
+    }
+
+    Print(line);
+}
+
+void CUCIEngine::PrintBestMove(const CSearchResult & result)
+{
+    // "0000" is the null move, for a position without legal moves
+    Print("bestmove " + (result.m_BestMove.IsValid() ? m_SearchGame.GetMoveName(result.m_BestMove) : std::string("0000")));
+}
+
+void CUCIEngine::Print(const std::string & line)
+{
+    std::lock_guard<std::mutex> lock(m_OutputMutex);
+
+    std::fputs(line.c_str(), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+} // namespace ChessProj
+
+int main()
+{
+    ChessProj::CUCIEngine engine;
+
+    return engine.Run();
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+TARGET   = ChessProjUCI
+TEMPLATE = app
+CONFIG  += console
+CONFIG  -= qt app_bundle
+
+CONFIG(debug, debug|release) {
+        DESTDIR = ../bin/debug/
+} else {
+        DESTDIR = ../bin/release/
+}
+
+include(ChessCore.pri)
+
+SOURCES     +=  UCI.cpp
+
+win32-msvc*: QMAKE_CXXFLAGS += /MP
\ No newline at end of file
@@ -11,5 +11,10 @@ call "c:\Qt\5.11.2\msvc2017_64\bin\qtenv2.bat"
 cd %ChessProjRoot%/src
 
 qmake -t vcapp ChessProj.pro
+qmake -t vcapp MakeBook.pro
+qmake -t vcapp MakeTablebase.pro
+qmake -t vcapp Perft.pro
+qmake -t vcapp SelfPlay.pro
+qmake -t vcapp UCI.pro
 
 ENDLOCAL